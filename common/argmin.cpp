@@ -0,0 +1,245 @@
+#include "argmin.hpp"
+
+#include <vector>
+
+#include <omp.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define ARGMIN_X86 1
+#endif
+
+// Below this many elements a parallel region costs more than the scan itself
+#define ARGMIN_MIN_PARALLEL (1 << 14)
+// Chunk boundaries are multiples of a cache line worth of floats
+#define ARGMIN_CHUNK_ALIGN 16
+
+typedef int (*argmin_kernel_t)(const float *values, int count);
+
+static int argmin_scalar(const float *values, int count)
+{
+    if (count <= 0)
+    {
+        return -1;
+    }
+
+    auto min_index = 0;
+    auto min = values[0];
+    for (auto i = 1; i < count; ++i)
+    {
+        if (values[i] < min)
+        {
+            min = values[i];
+            min_index = i;
+        }
+    }
+    return min_index;
+}
+
+#ifdef ARGMIN_X86
+
+// --- Both vector kernels make two passes: the minimum value with independent
+//     accumulators (no loop-carried compare/blend chain), then the first lane
+//     equal to it.  The second pass usually stops early and both stream
+//     through the same contiguous array.
+
+__attribute__((target("avx2")))
+static int argmin_avx2(const float *values, int count)
+{
+    if (count < 32)
+    {
+        return argmin_scalar(values, count);
+    }
+
+    auto acc0 = _mm256_loadu_ps(values);
+    auto acc1 = _mm256_loadu_ps(values + 8);
+    auto acc2 = _mm256_loadu_ps(values + 16);
+    auto acc3 = _mm256_loadu_ps(values + 24);
+    auto i = 32;
+    for (; i + 32 <= count; i += 32)
+    {
+        acc0 = _mm256_min_ps(acc0, _mm256_loadu_ps(values + i));
+        acc1 = _mm256_min_ps(acc1, _mm256_loadu_ps(values + i + 8));
+        acc2 = _mm256_min_ps(acc2, _mm256_loadu_ps(values + i + 16));
+        acc3 = _mm256_min_ps(acc3, _mm256_loadu_ps(values + i + 24));
+    }
+    for (; i + 8 <= count; i += 8)
+    {
+        acc0 = _mm256_min_ps(acc0, _mm256_loadu_ps(values + i));
+    }
+    acc0 = _mm256_min_ps(_mm256_min_ps(acc0, acc1), _mm256_min_ps(acc2, acc3));
+
+    auto half = _mm_min_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+    half = _mm_min_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_min_ss(half, _mm_shuffle_ps(half, half, 1));
+    auto min = _mm_cvtss_f32(half);
+    for (; i < count; ++i)
+    {
+        min = values[i] < min ? values[i] : min;
+    }
+
+    auto target = _mm256_set1_ps(min);
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        auto mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(values + i), target, _CMP_EQ_OQ));
+        if (mask != 0)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    for (; values[i] != min; ++i)
+    {
+    }
+    return i;
+}
+
+// GCC 12 reports the _mm512_undefined_ps() passthrough of the masked builtins
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx512f")))
+static int argmin_avx512(const float *values, int count)
+{
+    if (count < 64)
+    {
+        return argmin_avx2(values, count);
+    }
+
+    auto acc0 = _mm512_loadu_ps(values);
+    auto acc1 = _mm512_loadu_ps(values + 16);
+    auto acc2 = _mm512_loadu_ps(values + 32);
+    auto acc3 = _mm512_loadu_ps(values + 48);
+    auto i = 64;
+    for (; i + 64 <= count; i += 64)
+    {
+        acc0 = _mm512_min_ps(acc0, _mm512_loadu_ps(values + i));
+        acc1 = _mm512_min_ps(acc1, _mm512_loadu_ps(values + i + 16));
+        acc2 = _mm512_min_ps(acc2, _mm512_loadu_ps(values + i + 32));
+        acc3 = _mm512_min_ps(acc3, _mm512_loadu_ps(values + i + 48));
+    }
+    for (; i + 16 <= count; i += 16)
+    {
+        acc0 = _mm512_min_ps(acc0, _mm512_loadu_ps(values + i));
+    }
+    acc0 = _mm512_min_ps(_mm512_min_ps(acc0, acc1), _mm512_min_ps(acc2, acc3));
+
+    auto quarter = _mm256_min_ps(_mm512_castps512_ps256(acc0),
+                                 _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(acc0), 1)));
+    auto half = _mm_min_ps(_mm256_castps256_ps128(quarter), _mm256_extractf128_ps(quarter, 1));
+    half = _mm_min_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_min_ss(half, _mm_shuffle_ps(half, half, 1));
+    auto min = _mm_cvtss_f32(half);
+    for (; i < count; ++i)
+    {
+        min = values[i] < min ? values[i] : min;
+    }
+
+    auto target = _mm512_set1_ps(min);
+    for (i = 0; i + 16 <= count; i += 16)
+    {
+        auto mask = _mm512_cmp_ps_mask(_mm512_loadu_ps(values + i), target, _CMP_EQ_OQ);
+        if (mask != 0)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    for (; values[i] != min; ++i)
+    {
+    }
+    return i;
+}
+
+#pragma GCC diagnostic pop
+
+#endif
+
+struct ArgminKernel
+{
+    argmin_kernel_t run;
+    const char *isa;
+};
+
+static ArgminKernel detect_kernel()
+{
+#ifdef ARGMIN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return ArgminKernel{ argmin_avx512, "avx512" };
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return ArgminKernel{ argmin_avx2, "avx2" };
+    }
+#endif
+    return ArgminKernel{ argmin_scalar, "scalar" };
+}
+
+static const ArgminKernel &selected_kernel()
+{
+    static const ArgminKernel kernel = detect_kernel();
+    return kernel;
+}
+
+int argmin(const float *values, int count)
+{
+    return selected_kernel().run(values, count);
+}
+
+const char *argmin_isa()
+{
+    return selected_kernel().isa;
+}
+
+///
+/// Per-thread candidate, padded so that no two threads write the same line
+///
+struct ArgminSlot
+{
+    float value;
+    int index;
+    char padding[64 - sizeof(float) - sizeof(int)];
+};
+
+int argmin_parallel(const float *values, int count)
+{
+    if (count < ARGMIN_MIN_PARALLEL)
+    {
+        return argmin(values, count);
+    }
+
+    auto kernel = selected_kernel().run;
+    std::vector<ArgminSlot> slots(omp_get_max_threads());
+    int number_of_threads = 1;
+
+    #pragma omp parallel shared(slots, number_of_threads)
+    {
+        auto thread_num = omp_get_thread_num();
+        auto threads = omp_get_num_threads();
+        #pragma omp single nowait
+        number_of_threads = threads;
+
+        // Contiguous chunks in thread order, so the smallest index wins ties below
+        auto chunk = (count + threads - 1) / threads;
+        chunk = (chunk + ARGMIN_CHUNK_ALIGN - 1) / ARGMIN_CHUNK_ALIGN * ARGMIN_CHUNK_ALIGN;
+        auto begin = thread_num * chunk < count ? thread_num * chunk : count;
+        auto end = begin + chunk < count ? begin + chunk : count;
+
+        auto &slot = slots[thread_num];
+        auto index = kernel(values + begin, end - begin);
+        slot.index = index < 0 ? -1 : begin + index;
+        slot.value = index < 0 ? ARGMIN_MASKED : values[begin + index];
+    }
+
+    auto min_index = -1;
+    auto min = ARGMIN_MASKED;
+    for (auto t = 0; t < number_of_threads; ++t)
+    {
+        if (slots[t].index >= 0 && (min_index < 0 || slots[t].value < min))
+        {
+            min = slots[t].value;
+            min_index = slots[t].index;
+        }
+    }
+    return min_index;
+}
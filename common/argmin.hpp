@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cmath>
+
+///
+/// Argmin over a float array for the O(V^2) engines.
+///
+/// The engines keep their tentative distances with the finalized vertices
+/// masked out as ARGMIN_MASKED (+infinity, which sorts after FLT_MAX, the
+/// "unreachable" distance), so the scan is a plain contiguous float argmin
+/// with no visited test in the inner loop.  The kernel is chosen once at run
+/// time from what the CPU supports: AVX-512, AVX2 or a scalar loop.
+///
+/// Both functions return the first index of the minimum, or -1 for an empty
+/// range.
+///
+#define ARGMIN_MASKED INFINITY
+
+int argmin(const float *values, int count);
+
+// OpenMP version: every thread scans one cache-line aligned chunk and stores
+// its candidate in its own padded slot, the slots are reduced after the
+// parallel region, without locks
+int argmin_parallel(const float *values, int count);
+
+// "avx512", "avx2" or "scalar"
+const char *argmin_isa();
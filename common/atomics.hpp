@@ -0,0 +1,23 @@
+#pragma once
+
+#include <atomic>
+
+///
+/// Lock-free "store the minimum" on an atomic value; returns true when `value`
+/// replaced the previous contents.  Relaxed ordering is enough for the SSSP
+/// engines: the distances only ever decrease and every engine orders its
+/// phases with barriers.
+///
+template <typename T>
+inline bool atomic_min(std::atomic<T> &target, T value)
+{
+    auto current = target.load(std::memory_order_relaxed);
+    while (value < current)
+    {
+        if (target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+///
+/// Dial's bucket queue: a circular array of max_step + 1 buckets, one per
+/// integer key.  Holds for Dijkstra with integer weights <= max_step: all the
+/// keys in the queue lie in [current, current + max_step], so they map to
+/// distinct buckets modulo the array size.  Push is O(1), Pop scans forward to
+/// the next non-empty bucket, O(V * max_step + E) over a whole query.
+///
+/// There is no DecreaseKey: push the item again and skip the stale entries.
+///
+template <typename Key>
+class BucketQueue
+{
+    std::vector<std::vector<int>> buckets;
+    Key current;
+    size_t count;
+
+public:
+    explicit BucketQueue(uint64_t max_step) : buckets(max_step + 1), current(0), count(0)
+    {
+    }
+
+    bool Empty() const { return this->count == 0; }
+    size_t Size() const { return this->count; }
+
+    void Push(int item, Key key)
+    {
+        this->buckets[key % this->buckets.size()].push_back(item);
+        ++this->count;
+    }
+
+    // Remove an entry with the smallest key; the queue must not be empty
+    void Pop(int &item, Key &key)
+    {
+        auto *bucket = &this->buckets[this->current % this->buckets.size()];
+        while (bucket->empty())
+        {
+            ++this->current;
+            bucket = &this->buckets[this->current % this->buckets.size()];
+        }
+
+        item = bucket->back();
+        key = this->current;
+        bucket->pop_back();
+        --this->count;
+    }
+};
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <omp.h>
+
+#include "compressed_graph.hpp"
+
+static int varint_length(uint32_t value)
+{
+    auto length = 1;
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        ++length;
+    }
+    return length;
+}
+
+static uint8_t *write_varint(uint8_t *cursor, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        *cursor++ = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    *cursor++ = static_cast<uint8_t>(value);
+    return cursor;
+}
+
+static uint16_t quantize(float weight, float scale)
+{
+    auto quantized = std::lrint(static_cast<double>(weight) * scale);
+    return static_cast<uint16_t>(std::min(std::max(quantized, 0L), 65535L));
+}
+
+// Row of `vertex` as (target, weight) pairs, sorted by target
+static void sorted_row(const Graph &graph, int vertex, std::vector<std::pair<int, float>> &row)
+{
+    row.clear();
+    auto edge_end = graph.EdgesEnd(vertex);
+    for (auto edge = graph.EdgesBegin(vertex); edge < edge_end; ++edge)
+    {
+        row.emplace_back(graph.edge_array[edge], graph.weight_array[edge]);
+    }
+    std::sort(row.begin(), row.end());
+}
+
+// Bytes of one delta plus its weight
+static int encoded_length(uint32_t delta)
+{
+    return varint_length(delta) + static_cast<int>(sizeof(uint16_t));
+}
+
+static uint32_t zigzag(int value)
+{
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+CompressedGraph::CompressedGraph(const Graph &graph) : number_of_edges(0), weight_scale(1.f), lossless(true)
+{
+    auto number_of_vertexes = static_cast<int>(graph.vertex_array.size());
+    auto number_of_edges = static_cast<long long>(graph.edge_array.size());
+
+    this->csr_bytes = graph.vertex_array.size() * sizeof(int) + graph.edge_array.size() * sizeof(int) +
+                      graph.weight_array.size() * sizeof(float);
+
+    // --- Weight scale
+    this->weight_scale = graph.DecimalWeightScale(65535.);
+    this->lossless = this->weight_scale > 0.f;
+    if (!this->lossless)
+    {
+        auto max_weight = graph.MaxWeight();
+        this->weight_scale = max_weight > 0.f ? 65535.f / max_weight : 1.f;
+    }
+
+    // --- Row sizes, then the offsets as their prefix sum
+    std::vector<uint64_t> offsets(number_of_vertexes + 1, 0);
+    #pragma omp parallel
+    {
+        std::vector<std::pair<int, float>> row;
+
+        #pragma omp for schedule(dynamic, 256)
+        for (auto v = 0; v < number_of_vertexes; ++v)
+        {
+            sorted_row(graph, v, row);
+            uint64_t bytes = 0;
+            for (auto i = 0ULL; i < row.size(); ++i)
+            {
+                bytes += encoded_length(i == 0 ? zigzag(row[i].first - v)
+                                               : static_cast<uint32_t>(row[i].first - row[i - 1].first));
+            }
+            offsets[v + 1] = bytes;
+        }
+    }
+
+    for (auto v = 0; v < number_of_vertexes; ++v)
+    {
+        offsets[v + 1] += offsets[v];
+    }
+
+    if (offsets[number_of_vertexes] > std::numeric_limits<uint32_t>::max())
+    {
+        std::cerr << "Compressed graph needs " << offsets[number_of_vertexes]
+                  << " bytes, more than the 32-bit row offsets can address" << std::endl;
+        return;
+    }
+
+    this->row_offsets.assign(offsets.begin(), offsets.end());
+    this->stream.resize(offsets[number_of_vertexes]);
+    this->number_of_edges = static_cast<size_t>(number_of_edges);
+
+    // --- Encoding, every row is written in place
+    #pragma omp parallel
+    {
+        std::vector<std::pair<int, float>> row;
+
+        #pragma omp for schedule(dynamic, 256)
+        for (auto v = 0; v < number_of_vertexes; ++v)
+        {
+            sorted_row(graph, v, row);
+            auto cursor = this->stream.data() + this->row_offsets[v];
+            for (auto i = 0ULL; i < row.size(); ++i)
+            {
+                cursor = write_varint(cursor, i == 0 ? zigzag(row[i].first - v)
+                                                     : static_cast<uint32_t>(row[i].first - row[i - 1].first));
+                auto quantized = quantize(row[i].second, this->weight_scale);
+                std::memcpy(cursor, &quantized, sizeof(quantized));
+                cursor += sizeof(quantized);
+            }
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "graph.hpp"
+
+///
+/// Read-only compressed copy of the CSR arrays of a Graph, for engines that
+/// are bound by memory bandwidth.
+///
+/// Every row is sorted by target and stored in one byte stream as
+///
+///     [varint delta][uint16 weight] [varint delta][uint16 weight] ...
+///
+/// The first delta is zigzag(target - vertex), the following ones are the
+/// (non-negative) differences to the previous target, LEB128 encoded.  The
+/// weights are quantized to uint16 as round(w * scale) and decoded as
+/// q / scale; the scale is the first power of ten that reproduces every
+/// weight bit for bit (1000 for the generated k / 1000 weights), or
+/// 65535 / max weight if there is none, and then the weights are lossy.
+///
+/// Rows are found through 32-bit byte offsets, so the stream is limited to
+/// 4 GiB; a graph that does not fit is left empty with an error printed.
+///
+class CompressedGraph
+{
+    std::vector<uint32_t> row_offsets;      // V + 1 entries, row v is [row_offsets[v], row_offsets[v + 1])
+    std::vector<uint8_t> stream;
+    size_t number_of_edges;
+    size_t csr_bytes;
+    float weight_scale;
+    bool lossless;
+
+public:
+    explicit CompressedGraph(const Graph &graph);
+
+    int NumberOfVertexes() const { return this->row_offsets.empty() ? 0 : static_cast<int>(this->row_offsets.size() - 1); }
+    size_t NumberOfEdges() const { return this->number_of_edges; }
+
+    // Bytes of the offsets and the stream, and of the CSR arrays of the source graph
+    size_t Bytes() const { return this->row_offsets.size() * sizeof(uint32_t) + this->stream.size(); }
+    size_t CsrBytes() const { return this->csr_bytes; }
+
+    // True if every decoded weight equals the original one
+    bool IsLossless() const { return this->lossless; }
+    float WeightScale() const { return this->weight_scale; }
+
+    // Call visit(target, weight) for every outgoing edge of `vertex`, in
+    // increasing target order
+    template <typename Visitor>
+    void ForEachEdge(int vertex, Visitor visit) const
+    {
+        auto cursor = this->stream.data() + this->row_offsets[vertex];
+        auto end = this->stream.data() + this->row_offsets[vertex + 1];
+        if (cursor == end)
+        {
+            return;
+        }
+
+        auto first = read_varint(cursor);
+        auto target = vertex + (static_cast<int>(first >> 1) ^ -static_cast<int>(first & 1));
+        visit(target, read_weight(cursor));
+        while (cursor < end)
+        {
+            target += static_cast<int>(read_varint(cursor));
+            visit(target, read_weight(cursor));
+        }
+    }
+
+private:
+    static uint32_t read_varint(const uint8_t *&cursor)
+    {
+        uint32_t value = *cursor++;
+        if (value < 0x80)
+        {
+            return value;
+        }
+
+        value &= 0x7F;
+        for (auto shift = 7; ; shift += 7)
+        {
+            uint32_t byte = *cursor++;
+            value |= (byte & 0x7F) << shift;
+            if (byte < 0x80)
+            {
+                return value;
+            }
+        }
+    }
+
+    float read_weight(const uint8_t *&cursor) const
+    {
+        uint16_t quantized;
+        std::memcpy(&quantized, cursor, sizeof(quantized));
+        cursor += sizeof(quantized);
+        return static_cast<float>(quantized) / this->weight_scale;
+    }
+};
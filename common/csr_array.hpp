@@ -0,0 +1,116 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+///
+/// Storage for one of the CSR arrays of a Graph.
+///
+/// Behaves like the std::vector it replaces (size/data/operator[]/iterators/
+/// resize), but the elements can also live in memory owned by someone else,
+/// e.g. a memory-mapped snapshot file, in which case `owner` keeps that memory
+/// alive.  Resizing an adopted array first copies it into owned storage.
+///
+template <typename T>
+class CsrArray
+{
+    std::vector<T> storage;
+    T *elements;
+    size_t length;
+    std::shared_ptr<void> owner;
+
+public:
+    typedef T value_type;
+    typedef T *iterator;
+    typedef const T *const_iterator;
+
+    CsrArray() : elements(nullptr), length(0)
+    {
+    }
+
+    explicit CsrArray(size_t count, const T &value = T()) : storage(count, value), elements(storage.data()), length(count)
+    {
+    }
+
+    CsrArray(const CsrArray &other) : storage(other.begin(), other.end()), elements(storage.data()), length(other.length)
+    {
+    }
+
+    CsrArray(CsrArray &&other) : storage(std::move(other.storage)), elements(other.elements), length(other.length),
+                                 owner(std::move(other.owner))
+    {
+        other.elements = nullptr;
+        other.length = 0;
+    }
+
+    CsrArray &operator=(CsrArray other)
+    {
+        this->storage.swap(other.storage);
+        std::swap(this->elements, other.elements);
+        std::swap(this->length, other.length);
+        this->owner.swap(other.owner);
+        return *this;
+    }
+
+    // Use `count` elements at `external` without copying; `external_owner` keeps them valid
+    void Adopt(T *external, size_t count, std::shared_ptr<void> external_owner)
+    {
+        this->storage.clear();
+        this->storage.shrink_to_fit();
+        this->elements = external;
+        this->length = count;
+        this->owner = std::move(external_owner);
+    }
+
+    bool IsAdopted() const { return this->owner != nullptr; }
+
+    size_t size() const { return this->length; }
+    bool empty() const { return this->length == 0; }
+
+    T *data() { return this->elements; }
+    const T *data() const { return this->elements; }
+
+    T &operator[](size_t index) { return this->elements[index]; }
+    const T &operator[](size_t index) const { return this->elements[index]; }
+
+    iterator begin() { return this->elements; }
+    iterator end() { return this->elements + this->length; }
+    const_iterator begin() const { return this->elements; }
+    const_iterator end() const { return this->elements + this->length; }
+
+    void resize(size_t count, const T &value = T())
+    {
+        this->make_owned();
+        this->storage.resize(count, value);
+        this->elements = this->storage.data();
+        this->length = count;
+    }
+
+    void assign(size_t count, const T &value)
+    {
+        this->owner.reset();
+        this->storage.assign(count, value);
+        this->elements = this->storage.data();
+        this->length = count;
+    }
+
+    void clear()
+    {
+        this->owner.reset();
+        this->storage.clear();
+        this->elements = this->storage.data();
+        this->length = 0;
+    }
+
+private:
+    void make_owned()
+    {
+        if (this->owner)
+        {
+            this->storage.assign(this->begin(), this->end());
+            this->elements = this->storage.data();
+            this->owner.reset();
+        }
+    }
+};
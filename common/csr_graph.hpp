@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "csr_array.hpp"
+#include "graph.hpp"
+
+///
+/// CSR arrays with the edge weights in `Weight`, for the engines that work
+/// on integer costs (radix heap, Dial's buckets) rather than on the float
+/// weights of Graph.  Built from a Graph, whose vertex and edge arrays it
+/// copies: the weights become round(w * scale), with the scale from
+/// Graph::DecimalWeightScale so that the conversion is exact whenever the
+/// float weights allow it (k / 1000 -> k for the generated graphs).
+///
+template <typename Weight>
+class CsrGraph
+{
+    double weight_scale;
+    Weight max_weight;
+    bool lossless;
+
+public:
+    CsrArray<int> vertex_array;
+    CsrArray<int> edge_array;
+    CsrArray<Weight> weight_array;
+
+    explicit CsrGraph(const Graph &graph) :
+        vertex_array(graph.vertex_array), edge_array(graph.edge_array), weight_array(graph.weight_array.size())
+    {
+        auto max_quantized = static_cast<double>(std::numeric_limits<Weight>::max());
+
+        this->weight_scale = graph.DecimalWeightScale(max_quantized);
+        this->lossless = this->weight_scale > 0.;
+        if (!this->lossless)
+        {
+            auto max_float_weight = graph.MaxWeight();
+            this->weight_scale = max_float_weight > 0.f ? max_quantized / max_float_weight : 1.;
+        }
+
+        auto number_of_edges = static_cast<long long>(graph.weight_array.size());
+        Weight max_weight = 0;
+        #pragma omp parallel for reduction(max : max_weight)
+        for (auto edge = 0LL; edge < number_of_edges; ++edge)
+        {
+            auto quantized = std::nearbyint(static_cast<double>(graph.weight_array[edge]) * this->weight_scale);
+            this->weight_array[edge] = static_cast<Weight>(std::min(std::max(quantized, 0.), max_quantized));
+            max_weight = std::max(max_weight, this->weight_array[edge]);
+        }
+        this->max_weight = max_weight;
+    }
+
+    // Integer weight = round(float weight * WeightScale())
+    double WeightScale() const { return this->weight_scale; }
+    bool IsLossless() const { return this->lossless; }
+    Weight MaxWeight() const { return this->max_weight; }
+
+    int EdgesBegin(int vertex_num) const
+    {
+        return this->vertex_array[vertex_num];
+    }
+
+    int EdgesEnd(int vertex_num) const
+    {
+        return vertex_num + 1 < static_cast<int>(this->vertex_array.size()) ? this->vertex_array[vertex_num + 1]
+                                                                          : static_cast<int>(this->edge_array.size());
+    }
+
+    template <typename Visitor>
+    void ForEachEdge(int vertex, Visitor visit) const
+    {
+        auto edge_end = this->EdgesEnd(vertex);
+        for (auto edge = this->EdgesBegin(vertex); edge < edge_end; ++edge)
+        {
+            visit(this->edge_array[edge], this->weight_array[edge]);
+        }
+    }
+};
+
+///
+/// Integer costs: 32-bit weights, 64-bit distances so that no path length
+/// overflows, the maximum as infinity
+///
+typedef CsrGraph<uint32_t> IntegerGraph;
+typedef uint64_t IntegerDistance;
+#define INTEGER_DISTANCE_INFINITY (std::numeric_limits<IntegerDistance>::max())
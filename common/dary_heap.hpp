@@ -0,0 +1,150 @@
+#pragma once
+
+#include <vector>
+
+///
+/// Indexed d-ary min-heap over the vertex ids [0, capacity).
+///
+/// Entries are stored as (key, item) pairs in a single contiguous array so that
+/// all children of a node share one or two cache lines; a separate position
+/// array maps every item to its slot in the heap which makes DecreaseKey O(log_d n).
+///
+template <typename Key, int Arity = 4>
+class IndexedDaryHeap
+{
+    static_assert(Arity >= 2, "heap arity must be at least 2");
+
+    struct Entry
+    {
+        Key key;
+        int item;
+    };
+
+    std::vector<Entry> heap;
+    std::vector<int> positions;
+
+public:
+    explicit IndexedDaryHeap(int capacity = 0) : positions(capacity, -1)
+    {
+    }
+
+    // Grow (or shrink) the set of addressable items; the heap must be empty
+    void Resize(int capacity)
+    {
+        this->heap.clear();
+        this->positions.assign(capacity, -1);
+    }
+
+    bool Empty() const { return this->heap.empty(); }
+    size_t Size() const { return this->heap.size(); }
+    bool Contains(int item) const { return this->positions[item] >= 0; }
+
+    int Top() const { return this->heap.front().item; }
+    Key TopKey() const { return this->heap.front().key; }
+    Key GetKey(int item) const { return this->heap[this->positions[item]].key; }
+
+    void Push(int item, Key key)
+    {
+        this->heap.push_back(Entry{key, item});
+        this->sift_up(this->heap.size() - 1);
+    }
+
+    void DecreaseKey(int item, Key key)
+    {
+        auto pos = this->positions[item];
+        this->heap[pos].key = key;
+        this->sift_up(pos);
+    }
+
+    // Insert the item or lower its key, whichever applies
+    void PushOrDecrease(int item, Key key)
+    {
+        if (this->Contains(item))
+        {
+            this->DecreaseKey(item, key);
+        }
+        else
+        {
+            this->Push(item, key);
+        }
+    }
+
+    int Pop()
+    {
+        auto top = this->heap.front().item;
+        this->positions[top] = -1;
+
+        auto last = this->heap.back();
+        this->heap.pop_back();
+        if (!this->heap.empty())
+        {
+            this->sift_down(0, last);
+        }
+        return top;
+    }
+
+    // Empty the heap in O(size) so it can be reused for the next query
+    void Clear()
+    {
+        for (const auto &entry : this->heap)
+        {
+            this->positions[entry.item] = -1;
+        }
+        this->heap.clear();
+    }
+
+private:
+    void sift_up(size_t pos)
+    {
+        auto entry = this->heap[pos];
+        while (pos > 0)
+        {
+            auto parent = (pos - 1) / Arity;
+            if (!(entry.key < this->heap[parent].key))
+            {
+                break;
+            }
+            this->place(pos, this->heap[parent]);
+            pos = parent;
+        }
+        this->place(pos, entry);
+    }
+
+    // Move `entry` down starting from the (vacant) slot `pos`
+    void sift_down(size_t pos, Entry entry)
+    {
+        auto size = this->heap.size();
+        while (true)
+        {
+            auto first_child = pos * Arity + 1;
+            if (first_child >= size)
+            {
+                break;
+            }
+
+            auto last_child = first_child + Arity < size ? first_child + Arity : size;
+            auto best_child = first_child;
+            for (auto child = first_child + 1; child < last_child; ++child)
+            {
+                if (this->heap[child].key < this->heap[best_child].key)
+                {
+                    best_child = child;
+                }
+            }
+
+            if (!(this->heap[best_child].key < entry.key))
+            {
+                break;
+            }
+            this->place(pos, this->heap[best_child]);
+            pos = best_child;
+        }
+        this->place(pos, entry);
+    }
+
+    void place(size_t pos, const Entry &entry)
+    {
+        this->heap[pos] = entry;
+        this->positions[entry.item] = static_cast<int>(pos);
+    }
+};
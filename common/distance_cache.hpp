@@ -0,0 +1,94 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+///
+/// Least-recently-used cache of whole distance vectors, keyed by the source
+/// vertex, that holds at most `budget` bytes of distances.  Inserting evicts
+/// from the cold end until the new vector fits; a vector larger than the
+/// whole budget is not cached.  Entries are shared so that a caller can keep
+/// using a vector that gets evicted meanwhile.  Not thread-safe.
+///
+class DistanceCache
+{
+public:
+    typedef std::shared_ptr<const std::vector<float>> Entry;
+
+private:
+    typedef std::list<std::pair<int, Entry>> Order;
+
+    Order order;                                    // most recently used first
+    std::unordered_map<int, Order::iterator> index;
+    size_t budget;
+    size_t bytes;
+    long long hits;
+    long long misses;
+
+    static size_t size_of(const Entry &entry) { return entry->size() * sizeof(float); }
+
+public:
+    explicit DistanceCache(size_t budget) : budget(budget), bytes(0), hits(0), misses(0)
+    {
+    }
+
+    // The cached distances from `source_vertex`, nullptr on a miss
+    Entry Find(int source_vertex)
+    {
+        auto found = this->index.find(source_vertex);
+        if (found == this->index.end())
+        {
+            ++this->misses;
+            return nullptr;
+        }
+
+        ++this->hits;
+        this->order.splice(this->order.begin(), this->order, found->second);
+        return found->second->second;
+    }
+
+    void Insert(int source_vertex, Entry distances)
+    {
+        auto size = size_of(distances);
+        if (size > this->budget)
+        {
+            return;
+        }
+
+        auto found = this->index.find(source_vertex);
+        if (found != this->index.end())
+        {
+            this->bytes -= size_of(found->second->second);
+            this->order.erase(found->second);
+            this->index.erase(found);
+        }
+
+        while (this->bytes + size > this->budget)
+        {
+            this->bytes -= size_of(this->order.back().second);
+            this->index.erase(this->order.back().first);
+            this->order.pop_back();
+        }
+
+        this->order.push_front(std::make_pair(source_vertex, std::move(distances)));
+        this->index[source_vertex] = this->order.begin();
+        this->bytes += size;
+    }
+
+    // Drops the entries, the hit and miss counters stay
+    void Clear()
+    {
+        this->order.clear();
+        this->index.clear();
+        this->bytes = 0;
+    }
+
+    size_t Size() const { return this->index.size(); }
+    size_t Bytes() const { return this->bytes; }
+    size_t Budget() const { return this->budget; }
+    long long Hits() const { return this->hits; }
+    long long Misses() const { return this->misses; }
+};
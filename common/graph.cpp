@@ -1,80 +1,173 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <iostream>
 #include <cfloat>
 #include <climits>
 #include <omp.h>
 
 #include "graph.hpp"
+#include "argmin.hpp"
 
+// Largest power of ten DecimalWeightScale tries
+#define GRAPH_MAX_DECIMAL_SCALE 1000000.f
 
-Graph::Graph(int num_vertexes, int neighbors_per_vertex) :
-                                neighbors_per_vertex(neighbors_per_vertex),
-                                vertex_array(num_vertexes),
-                                edge_array(num_vertexes * neighbors_per_vertex),
-                                weight_array(num_vertexes * neighbors_per_vertex),
-                                weight_matrix(num_vertexes * num_vertexes)
+Graph::Graph(int num_vertexes, int neighbors_per_vertex, graph_storage_t storage,
+             graph_topology_t topology, uint64_t seed) :
+                                neighbors_per_vertex(neighbors_per_vertex), revision(0),
+                                weight_matrix_once(new std::once_flag), reverse_once(new std::once_flag)
 {
-    this->generate_data(num_vertexes, neighbors_per_vertex);
+    this->generate_data(num_vertexes, neighbors_per_vertex, topology, seed);
+    this->finish_construction(storage);
 }
 
-void Graph::generate_data(int num_vertexes, int neighbors_per_vertex)
+Graph::Graph() : neighbors_per_vertex(0), revision(0), weight_matrix_once(new std::once_flag),
+                 reverse_once(new std::once_flag)
 {
-    #pragma omp parallel for
-    for (int i = 0; i < num_vertexes; ++i)
+}
+
+void Graph::finish_construction(graph_storage_t storage)
+{
+    this->renew_revision();
+
+    if (storage == GRAPH_STORAGE_DENSE)
     {
-        this->vertex_array[i] = i * neighbors_per_vertex;
+        this->WeightMatrix();
     }
+}
+
+void Graph::renew_revision()
+{
+    static std::atomic<uint64_t> next_revision(1);
+    this->revision = next_revision.fetch_add(1);
+}
 
-    for (int k = 0; k < num_vertexes; ++k)
+int Graph::EdgeSource(int edge) const
+{
+    // Last vertex whose row starts at or before the edge; rows of vertices
+    // without edges start at the same offset as the next row
+    auto row = std::upper_bound(this->vertex_array.begin(), this->vertex_array.end(), edge);
+    return static_cast<int>(row - this->vertex_array.begin()) - 1;
+}
+
+void Graph::UpdateWeights(const std::vector<EdgeWeightUpdate> &updates)
+{
+    auto number_of_vertexes = this->vertex_array.size();
+    auto has_reverse = this->reverse != nullptr;
+
+    for (const auto &update : updates)
     {
-        std::vector<int> temp_array(neighbors_per_vertex, INT_MAX);
-        #pragma omp parallel for shared(temp_array)
-        for (int l = 0; l < neighbors_per_vertex; ++l)
+        this->weight_array[update.edge] = update.weight;
+        if (this->weight_matrix.empty() && !has_reverse)
         {
-            bool skip_iteration = false;
-            int temp = 0;
-            while (!skip_iteration)
+            continue;
+        }
+
+        auto u = this->EdgeSource(update.edge);
+        auto v = this->edge_array[update.edge];
+
+        // Parallel edges u -> v: the matrix keeps the last one of the row, the
+        // reverse row of v keeps them in row order after the edges of smaller sources
+        auto last = update.edge;
+        auto earlier = 0;
+        auto edge_end = this->EdgesEnd(u);
+        for (auto edge = this->EdgesBegin(u); edge < edge_end; ++edge)
+        {
+            if (this->edge_array[edge] == v)
             {
-                skip_iteration = true;
-
-                temp = rand() % num_vertexes;
-                for (auto t = 0ULL; t < temp_array.size(); ++t)
-                {
-                    if (temp == temp_array[t])
-                    {
-                        skip_iteration = false;
-                        break;
-                    }
-                }
-                if (temp == k)
-                {
-                    skip_iteration = false;
-                }
-                if (skip_iteration)
-                {
-                    temp_array[l] = temp;
-                }
+                last = edge;
+                earlier += edge < update.edge ? 1 : 0;
             }
-            this->edge_array[k * neighbors_per_vertex + l] = temp;
-            this->weight_array[k * neighbors_per_vertex + l] = (float)(rand() % 1000) / 1000.0f;
         }
+
+        if (!this->weight_matrix.empty())
+        {
+            this->weight_matrix[u * number_of_vertexes + v] = this->weight_array[last];
+        }
+        if (has_reverse)
+        {
+            const auto &sources = this->reverse->edge_array;
+            auto first = std::lower_bound(sources.begin() + this->reverse->EdgesBegin(v),
+                                          sources.begin() + this->reverse->EdgesEnd(v), u);
+            this->reverse->weight_array[first - sources.begin() + earlier] = update.weight;
+        }
+    }
+
+    this->renew_revision();
+    if (has_reverse)
+    {
+        this->reverse->renew_revision();
     }
-    // Generate weight matrix
+}
+
+const std::vector<float> &Graph::WeightMatrix() const
+{
+    std::call_once(*this->weight_matrix_once, &Graph::build_weight_matrix, this);
+    return this->weight_matrix;
+}
+
+void Graph::build_weight_matrix() const
+{
+    auto num_vertexes = this->vertex_array.size();
+    this->weight_matrix.assign(num_vertexes * num_vertexes, 0.f);
+
     #pragma omp parallel for
-    for (auto k = 0; k < num_vertexes; ++k)
+    for (auto k = 0LL; k < static_cast<long long>(num_vertexes); ++k)
     {
-        weight_matrix[k * num_vertexes + k] = 0.f;
+        auto row = this->weight_matrix.data() + k * num_vertexes;
+        row[k] = 0.f;
+
+        auto edge_end = this->EdgesEnd(k);
+        for (auto edge = this->EdgesBegin(k); edge < edge_end; ++edge)
+        {
+            row[this->edge_array[edge]] = this->weight_array[edge];
+        }
     }
+}
+
+const Graph &Graph::Reverse() const
+{
+    std::call_once(*this->reverse_once, &Graph::build_reverse, this);
+    return *this->reverse;
+}
+
+void Graph::build_reverse() const
+{
+    auto number_of_vertexes = static_cast<int>(this->vertex_array.size());
+    auto number_of_edges = this->edge_array.size();
 
-    for (auto k = 0; k < num_vertexes; ++k)
+    std::unique_ptr<Graph> reverse(new Graph());
+    reverse->neighbors_per_vertex = this->neighbors_per_vertex;
+    reverse->vertex_array = CsrArray<int>(number_of_vertexes, 0);
+    reverse->edge_array = CsrArray<int>(number_of_edges);
+    reverse->weight_array = CsrArray<float>(number_of_edges);
+
+    // Counting sort by target: in-degrees, their prefix sum, then a scatter
+    // in source order so that every reverse row comes out sorted
+    std::vector<int> slots(number_of_vertexes + 1, 0);
+    for (auto edge = 0ULL; edge < number_of_edges; ++edge)
+    {
+        ++slots[this->edge_array[edge] + 1];
+    }
+    for (auto v = 0; v < number_of_vertexes; ++v)
+    {
+        slots[v + 1] += slots[v];
+        reverse->vertex_array[v] = slots[v];
+    }
+
+    for (auto u = 0; u < number_of_vertexes; ++u)
     {
-        #pragma omp parallel for shared(neighbors_per_vertex, k)
-        for (int l = 0; l < neighbors_per_vertex; ++l)
+        auto edge_end = this->EdgesEnd(u);
+        for (auto edge = this->EdgesBegin(u); edge < edge_end; ++edge)
         {
-            auto edge = this->edge_array[this->vertex_array[k] + l];
-            auto weight = this->weight_array[this->vertex_array[k] + l];
-            weight_matrix[k * num_vertexes + edge] = weight;
+            auto slot = slots[this->edge_array[edge]]++;
+            reverse->edge_array[slot] = u;
+            reverse->weight_array[slot] = this->weight_array[edge];
         }
     }
+
+    reverse->finish_construction(GRAPH_STORAGE_SPARSE);
+    this->reverse = std::move(reverse);
 }
 
 inline int Graph::GetEdge(int vertex_num, int neighbor_idx) const
@@ -93,7 +186,9 @@ void Graph::PrintVertexData() const
 
     for (auto k = 0ULL; k < num_vertices; ++k)
     {
-        for (auto l = 0; l < this->neighbors_per_vertex; ++l)
+        // Degrees vary per vertex for every topology but the uniform one
+        auto degree = this->EdgesEnd(k) - this->EdgesBegin(k);
+        for (auto l = 0; l < degree; ++l)
         {
             auto edge = this->GetEdge(k, l);
             auto weight = this->GetWeight(k, l);
@@ -102,7 +197,7 @@ void Graph::PrintVertexData() const
         }
     }
 
-    for (auto k = 0ULL; k < num_vertices * this->neighbors_per_vertex; ++k)
+    for (auto k = 0ULL; k < this->edge_array.size(); ++k)
     {
         std::cout << k << " " << this->edge_array[k] << " " << this->weight_array[k] << std::endl;
     }
@@ -111,16 +206,17 @@ void Graph::PrintVertexData() const
 void Graph::DisplayWeightMatrix() const
 {
     auto num_vertices = this->vertex_array.size();
+    const auto &weight_matrix = this->WeightMatrix();
 
     std::cout << "Weight matrix" << std::endl;
     for (auto k = 0ULL; k < num_vertices; ++k)
     {
         for (auto l = 0ULL; l < num_vertices; ++l)
         {
-            if (this->weight_matrix[k * num_vertices + l] < FLT_MAX)
+            if (weight_matrix[k * num_vertices + l] < FLT_MAX)
             {
                 std::cout.precision(3);
-                std::cout << this->weight_matrix[k * num_vertices + l] << "\t";
+                std::cout << weight_matrix[k * num_vertices + l] << "\t";
             }
             else
             {
@@ -131,59 +227,50 @@ void Graph::DisplayWeightMatrix() const
     }
 }
 
-int Graph::MinDistances(const std::vector<float>& shortest_path,
-                        const std::vector<bool>& finalized_verticies,
-                        int start_vertex) const
+int Graph::MinDistances(const std::vector<float>& tentative_distances) const
 {
-    auto minIndex = start_vertex;
-    auto min = FLT_MAX;
-
-    for (auto v = 0ULL; v < this->vertex_array.size(); v++)
-    {
-        if (finalized_verticies[v] == false && shortest_path[v] <= min)
-        {
-            min = shortest_path[v];
-            minIndex = v;
-        }
-    }
-
-    return minIndex;
+    return argmin(tentative_distances.data(), static_cast<int>(tentative_distances.size()));
 }
 
-int Graph::MinDistancesOMP(const std::vector<float>& shortest_path,
-                           const std::vector<bool>& finalized_verticies,
-                           int start_vertex) const
+int Graph::MinDistancesOMP(const std::vector<float>& tentative_distances) const
 {
-    int min_vertex = start_vertex;
-    float min_dist = FLT_MAX;
+    return argmin_parallel(tentative_distances.data(), static_cast<int>(tentative_distances.size()));
+}
 
-    float thread_min_dist;
-    int thread_min_vertex;
+float Graph::MaxWeight() const
+{
+    auto number_of_edges = static_cast<long long>(this->weight_array.size());
+    auto max_weight = 0.f;
 
-    #pragma omp parallel private(thread_min_dist, thread_min_vertex) shared(shortest_path, finalized_verticies, start_vertex, min_vertex, min_dist)
+    #pragma omp parallel for reduction(max : max_weight)
+    for (auto edge = 0LL; edge < number_of_edges; ++edge)
     {
-        thread_min_dist = min_dist;
-        thread_min_vertex = min_vertex;
+        max_weight = std::max(max_weight, this->weight_array[edge]);
+    }
+    return max_weight;
+}
 
-        #pragma omp barrier
+float Graph::DecimalWeightScale(double max_quantized) const
+{
+    auto number_of_edges = static_cast<long long>(this->weight_array.size());
+    auto max_weight = this->MaxWeight();
 
-        #pragma omp for nowait
-        for (auto v = 0ULL; v < this->vertex_array.size(); ++v)
+    for (auto scale = 1.f; scale <= GRAPH_MAX_DECIMAL_SCALE && max_weight * static_cast<double>(scale) <= max_quantized;
+         scale *= 10.f)
+    {
+        auto exact = true;
+        #pragma omp parallel for reduction(&& : exact)
+        for (auto edge = 0LL; edge < number_of_edges; ++edge)
         {
-            if (finalized_verticies[v] == false && shortest_path[v] <= thread_min_dist)
-            {
-                thread_min_dist = shortest_path[v];
-                thread_min_vertex = v;
-            }
+            auto weight = this->weight_array[edge];
+            auto quantized = std::nearbyint(static_cast<double>(weight) * scale);
+            exact = exact && weight >= 0.f && static_cast<float>(quantized) / scale == weight;
         }
-        #pragma omp critical
+
+        if (exact)
         {
-            if (thread_min_dist < min_dist)
-            {
-                min_dist = thread_min_dist;
-                min_vertex = thread_min_vertex;
-            }
+            return scale;
         }
     }
-    return min_vertex;
+    return 0.f;
 }
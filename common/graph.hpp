@@ -1,32 +1,171 @@
 #pragma once
 
 #include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+#include "csr_array.hpp"
+
+typedef enum graph_storage_e
+{
+    GRAPH_STORAGE_DENSE,    // CSR arrays plus the V x V weight matrix, built up front
+    GRAPH_STORAGE_SPARSE,   // CSR arrays only, the weight matrix is built on first use
+} graph_storage_t;
+
+typedef enum graph_topology_e
+{
+    GRAPH_TOPOLOGY_UNIFORM,       // exactly neighbors_per_vertex distinct random neighbours per vertex
+    GRAPH_TOPOLOGY_ERDOS_RENYI,   // G(n, p) with p chosen for an average degree of neighbors_per_vertex
+    GRAPH_TOPOLOGY_RMAT,          // power-law R-MAT graph with about n * neighbors_per_vertex edges
+    GRAPH_TOPOLOGY_GRID,          // 2D road-like grid, 4 neighbours (8 if neighbors_per_vertex >= 8)
+} graph_topology_t;
+
+typedef enum graph_ordering_e
+{
+    GRAPH_ORDERING_BFS,           // breadth-first from vertex 0 (and from every part it does not reach)
+    GRAPH_ORDERING_RCM,           // reverse Cuthill-McKee
+    GRAPH_ORDERING_DEGREE,        // decreasing out-degree
+} graph_ordering_t;
+
+// New weight of one edge, by its index in the CSR arrays
+struct EdgeWeightUpdate
+{
+    int edge;
+    float weight;
+};
 
 class Graph
 {
     int neighbors_per_vertex;
+    uint64_t revision;
+
+    // Renumbering of a Reordered() graph: new id -> original id and back,
+    // both empty for any other graph
+    std::vector<int> original_ids;
+    std::vector<int> internal_ids;
+
+    // V x V weight matrix, materialized lazily by WeightMatrix()
+    mutable std::vector<float> weight_matrix;
+    mutable std::unique_ptr<std::once_flag> weight_matrix_once;
+
+    // Transposed graph, built lazily by Reverse()
+    mutable std::unique_ptr<Graph> reverse;
+    mutable std::unique_ptr<std::once_flag> reverse_once;
 
 public:
-    std::vector<int> vertex_array;
-    std::vector<int> edge_array;
-    std::vector<float> weight_array;
-    std::vector<float> weight_matrix;
+    CsrArray<int> vertex_array;
+    CsrArray<int> edge_array;
+    CsrArray<float> weight_array;
+
+    // The generated graph is a pure function of the parameters and the seed,
+    // whatever the number of OpenMP threads
+    Graph(int num_vertexes, int neighbors_per_vertex, graph_storage_t storage = GRAPH_STORAGE_DENSE,
+          graph_topology_t topology = GRAPH_TOPOLOGY_UNIFORM, uint64_t seed = 0);
+
+    // Streaming loaders for DIMACS 9th challenge .gr files and SNAP edge lists
+    // ("from to [weight]", '#' comments, weight 1 when absent).  Both parse the
+    // file twice in parallel chunks (degrees, then a counting-sort scatter) and
+    // never hold more than one chunk of text.  Lines with an id above
+    // INT_MAX - 1 or a weight that is not a finite non-negative number are
+    // skipped and counted.  On failure the error is printed and an empty graph
+    // is returned.
+    static Graph FromDimacs(const std::string &path, graph_storage_t storage = GRAPH_STORAGE_SPARSE);
+    static Graph FromSnap(const std::string &path, bool undirected = false,
+                          graph_storage_t storage = GRAPH_STORAGE_SPARSE);
+
+    // Versioned binary CSR snapshot (see graph_snapshot.cpp).  FromSnapshot
+    // maps the file and uses the arrays in place, the pages are shared with
+    // every other process that maps the same file.  The header regions and
+    // the CSR structure (offsets, edge targets) are always checked; `verify`
+    // additionally checks the checksum, which also covers the weights.
+    bool SaveSnapshot(const std::string &path) const;
+    static Graph FromSnapshot(const std::string &path, bool verify = false,
+                              graph_storage_t storage = GRAPH_STORAGE_SPARSE);
 
-    Graph(int num_vertexes, int neighbors_per_vertex);
+    // Copy with the vertices renumbered for locality and every CSR row sorted
+    // by target (see graph_reorder.cpp).  The copy remembers the permutation:
+    // InternalId maps a query source into it, ToOriginalOrder maps its
+    // results back.  A snapshot of the copy does not keep the permutation.
+    Graph Reordered(graph_ordering_t ordering) const;
+
+    bool IsReordered() const { return !this->original_ids.empty(); }
+    int OriginalId(int vertex) const { return this->IsReordered() ? this->original_ids[vertex] : vertex; }
+    int InternalId(int original_vertex) const
+    {
+        return this->IsReordered() ? this->internal_ids[original_vertex] : original_vertex;
+    }
+
+    // Per-vertex results of a query on this graph, indexed by original id
+    std::vector<float> ToOriginalOrder(const std::vector<float> &distances) const;
+    std::vector<int> ParentsToOriginalOrder(const std::vector<int> &parents) const;
+
+    // Process-wide unique id of the graph contents, assigned when the graph is
+    // built or loaded and renewed by UpdateWeights; device backends use it to
+    // tell whether their resident copy of the arrays is still current
+    uint64_t Revision() const { return this->revision; }
+
+    // Set the weights of a batch of edges in place.  The weight matrix and
+    // Reverse(), if already built, are patched rather than rebuilt, and the
+    // graph gets a new Revision().  Must not run concurrently with queries.
+    void UpdateWeights(const std::vector<EdgeWeightUpdate> &updates);
+
+    // Vertex the edge leaves from, a binary search over vertex_array
+    int EdgeSource(int edge) const;
+
+    // Average out-degree (exact for GRAPH_TOPOLOGY_UNIFORM)
+    int NeighborsPerVertex() const { return this->neighbors_per_vertex; }
+
+    // Largest edge weight, 0 for a graph without edges
+    float MaxWeight() const;
+
+    // Smallest power of ten s (up to 10^6) that makes every weight w an
+    // integer q = w * s <= max_quantized which decodes back as q / s == w,
+    // bit for bit in float; 0 if there is none.  1000 for generated graphs.
+    float DecimalWeightScale(double max_quantized) const;
+
+    // Dense weight matrix, row-major; built (once, thread-safe) on the first call
+    const std::vector<float> &WeightMatrix() const;
+    bool HasWeightMatrix() const { return !this->weight_matrix.empty(); }
+
+    // Graph with every edge u -> v turned into v -> u (rows sorted by the
+    // original source), for backward searches; built once on the first call,
+    // thread-safe
+    const Graph &Reverse() const;
 
     inline int GetEdge(int vertex_num, int neighbor_idx) const;
     inline float GetWeight(int vertex_num, int neighbor_idx) const;
 
+    // CSR bounds of the outgoing edges of a vertex: [EdgesBegin, EdgesEnd)
+    int EdgesBegin(int vertex_num) const
+    {
+        return this->vertex_array[vertex_num];
+    }
+
+    int EdgesEnd(int vertex_num) const
+    {
+        return vertex_num + 1 < static_cast<int>(this->vertex_array.size()) ? this->vertex_array[vertex_num + 1]
+                                                                          : static_cast<int>(this->edge_array.size());
+    }
+
     void DisplayWeightMatrix() const;
     void PrintVertexData() const;
 
-    int MinDistances(const std::vector<float>& shortest_path,
-                     const std::vector<bool>& finalized_verticies,
-                     int start_vertex) const;
-
-    int MinDistancesOMP(const std::vector<float>& shortest_path,
-                        const std::vector<bool>& finalized_verticies,
-                        int start_vertex) const;
+    // Vertex with the smallest tentative distance; the finalized vertices are
+    // masked out as ARGMIN_MASKED (see common/argmin.hpp)
+    int MinDistances(const std::vector<float>& tentative_distances) const;
+    int MinDistancesOMP(const std::vector<float>& tentative_distances) const;
 private:
-    void generate_data(int num_vertexes, int neighbors_per_vertex);
+    Graph();
+
+    void finish_construction(graph_storage_t storage);
+    void renew_revision();
+    void generate_data(int num_vertexes, int neighbors_per_vertex, graph_topology_t topology, uint64_t seed);
+    void generate_uniform(int num_vertexes, int neighbors_per_vertex, uint64_t seed);
+    void generate_erdos_renyi(int num_vertexes, int neighbors_per_vertex, uint64_t seed);
+    void generate_rmat(int num_vertexes, int neighbors_per_vertex, uint64_t seed);
+    void generate_grid(int num_vertexes, int neighbors_per_vertex, uint64_t seed);
+    void build_weight_matrix() const;
+    void build_reverse() const;
 };
\ No newline at end of file
@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <omp.h>
+
+#include "graph.hpp"
+#include "random.hpp"
+
+// R-MAT quadrant probabilities (Graph500 defaults), the fourth one is 1 - a - b - c
+#define RMAT_A 0.57
+#define RMAT_B 0.19
+#define RMAT_C 0.19
+
+///
+/// Edge weights are k / 1000 with k in [1, 1000]: zero is reserved, the weight
+/// matrix uses it to mark missing edges.
+///
+static float random_weight(CounterRng &rng)
+{
+    return (float)(1 + rng.NextBounded(1000)) / 1000.0f;
+}
+
+///
+/// Turn per-vertex degrees into CSR offsets, returns the total number of edges.
+///
+template <typename Offsets>
+static int degrees_to_offsets(const std::vector<int> &degrees, Offsets &offsets)
+{
+    offsets.resize(degrees.size());
+
+    int total = 0;
+    for (auto v = 0ULL; v < degrees.size(); ++v)
+    {
+        offsets[v] = total;
+        total += degrees[v];
+    }
+    return total;
+}
+
+void Graph::generate_data(int num_vertexes, int neighbors_per_vertex, graph_topology_t topology, uint64_t seed)
+{
+    switch (topology)
+    {
+        case GRAPH_TOPOLOGY_UNIFORM:
+            this->generate_uniform(num_vertexes, neighbors_per_vertex, seed);
+            break;
+        case GRAPH_TOPOLOGY_ERDOS_RENYI:
+            this->generate_erdos_renyi(num_vertexes, neighbors_per_vertex, seed);
+            break;
+        case GRAPH_TOPOLOGY_RMAT:
+            this->generate_rmat(num_vertexes, neighbors_per_vertex, seed);
+            break;
+        case GRAPH_TOPOLOGY_GRID:
+            this->generate_grid(num_vertexes, neighbors_per_vertex, seed);
+            break;
+    }
+
+    // For the variable-degree topologies this becomes the actual average degree
+    this->neighbors_per_vertex = num_vertexes > 0 ? static_cast<int>(this->edge_array.size() / num_vertexes) : 0;
+}
+
+void Graph::generate_uniform(int num_vertexes, int neighbors_per_vertex, uint64_t seed)
+{
+    neighbors_per_vertex = std::max(0, std::min(neighbors_per_vertex, num_vertexes - 1));
+
+    this->vertex_array.resize(num_vertexes);
+    this->edge_array.resize(static_cast<size_t>(num_vertexes) * neighbors_per_vertex);
+    this->weight_array.resize(this->edge_array.size());
+
+    #pragma omp parallel for schedule(static)
+    for (int k = 0; k < num_vertexes; ++k)
+    {
+        // One random stream per vertex
+        CounterRng rng(seed, k);
+
+        this->vertex_array[k] = k * neighbors_per_vertex;
+        auto row = this->edge_array.data() + this->vertex_array[k];
+        auto row_weights = this->weight_array.data() + this->vertex_array[k];
+
+        for (int l = 0; l < neighbors_per_vertex; ++l)
+        {
+            int temp;
+            do
+            {
+                temp = rng.NextBounded(num_vertexes);
+            } while (temp == k || std::find(row, row + l, temp) != row + l);
+
+            row[l] = temp;
+            row_weights[l] = random_weight(rng);
+        }
+    }
+}
+
+void Graph::generate_erdos_renyi(int num_vertexes, int neighbors_per_vertex, uint64_t seed)
+{
+    auto candidates = num_vertexes - 1;
+    auto probability = candidates > 0 ? std::min(1.0, static_cast<double>(neighbors_per_vertex) / candidates) : 0.0;
+    auto log_q = std::log(1.0 - probability);
+
+    // Draw the neighbours of vertex k by geometric skipping over the other
+    // n - 1 vertices; with `edges` == nullptr only count them.  Both passes
+    // replay the same per-vertex stream so they agree on the outcome.
+    auto draw = [&](int k, int *edges, float *weights) -> int
+    {
+        CounterRng rng(seed, k);
+        int count = 0;
+
+        if (probability <= 0.0)
+        {
+            return 0;
+        }
+
+        long long candidate = -1;
+        while (true)
+        {
+            if (probability >= 1.0)
+            {
+                candidate += 1;
+            }
+            else
+            {
+                candidate += 1 + static_cast<long long>(std::log(1.0 - rng.NextDouble()) / log_q);
+            }
+            if (candidate >= candidates)
+            {
+                break;
+            }
+
+            auto weight = random_weight(rng);
+            if (edges != nullptr)
+            {
+                edges[count] = candidate < k ? static_cast<int>(candidate) : static_cast<int>(candidate) + 1;
+                weights[count] = weight;
+            }
+            ++count;
+        }
+        return count;
+    };
+
+    std::vector<int> degrees(num_vertexes);
+
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (int k = 0; k < num_vertexes; ++k)
+    {
+        degrees[k] = draw(k, nullptr, nullptr);
+    }
+
+    auto number_of_edges = degrees_to_offsets(degrees, this->vertex_array);
+    this->edge_array.resize(number_of_edges);
+    this->weight_array.resize(number_of_edges);
+
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (int k = 0; k < num_vertexes; ++k)
+    {
+        draw(k, this->edge_array.data() + this->vertex_array[k], this->weight_array.data() + this->vertex_array[k]);
+    }
+}
+
+void Graph::generate_rmat(int num_vertexes, int neighbors_per_vertex, uint64_t seed)
+{
+    // Without two distinct vertices there is nothing to sample
+    auto number_of_samples = num_vertexes > 1 ? static_cast<long long>(num_vertexes) * neighbors_per_vertex : 0LL;
+
+    int scale = 0;
+    while ((1LL << scale) < num_vertexes)
+    {
+        ++scale;
+    }
+
+    // --- Sample the edges, one random stream per edge slot
+    std::vector<int> sources(number_of_samples);
+    std::vector<int> targets(number_of_samples);
+    std::vector<float> weights(number_of_samples);
+    std::vector<int> degrees(num_vertexes, 0);
+
+    #pragma omp parallel for schedule(static)
+    for (long long e = 0; e < number_of_samples; ++e)
+    {
+        CounterRng rng(seed, e);
+        long long u, v;
+        do
+        {
+            u = v = 0;
+            for (int level = 0; level < scale; ++level)
+            {
+                auto r = rng.NextDouble();
+                auto bit = 1LL << level;
+                if (r >= RMAT_A + RMAT_B + RMAT_C)
+                {
+                    u |= bit;
+                    v |= bit;
+                }
+                else if (r >= RMAT_A + RMAT_B)
+                {
+                    u |= bit;
+                }
+                else if (r >= RMAT_A)
+                {
+                    v |= bit;
+                }
+            }
+        } while (u >= num_vertexes || v >= num_vertexes || u == v);
+
+        sources[e] = static_cast<int>(u);
+        targets[e] = static_cast<int>(v);
+        weights[e] = random_weight(rng);
+
+        #pragma omp atomic
+        degrees[u]++;
+    }
+
+    // --- Counting sort by source
+    std::vector<int> offsets;
+    degrees_to_offsets(degrees, offsets);
+    std::vector<int> cursor(offsets);
+    std::vector<std::pair<int, float>> adjacency(number_of_samples);
+
+    #pragma omp parallel for schedule(static)
+    for (long long e = 0; e < number_of_samples; ++e)
+    {
+        int slot;
+        #pragma omp atomic capture
+        slot = cursor[sources[e]]++;
+
+        adjacency[slot] = std::make_pair(targets[e], weights[e]);
+    }
+
+    sources.clear();
+    sources.shrink_to_fit();
+    targets.clear();
+    targets.shrink_to_fit();
+
+    // The scatter above is racy in order, sorting each row makes the result
+    // deterministic again; duplicate edges keep their lightest copy
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (int k = 0; k < num_vertexes; ++k)
+    {
+        auto first = adjacency.begin() + offsets[k];
+        auto last = first + degrees[k];
+        std::sort(first, last);
+        auto unique_end = std::unique(first, last, [](const std::pair<int, float> &a, const std::pair<int, float> &b)
+        {
+            return a.first == b.first;
+        });
+        degrees[k] = static_cast<int>(unique_end - first);
+    }
+
+    auto number_of_edges = degrees_to_offsets(degrees, this->vertex_array);
+    this->edge_array.resize(number_of_edges);
+    this->weight_array.resize(number_of_edges);
+
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (int k = 0; k < num_vertexes; ++k)
+    {
+        for (int l = 0; l < degrees[k]; ++l)
+        {
+            this->edge_array[this->vertex_array[k] + l] = adjacency[offsets[k] + l].first;
+            this->weight_array[this->vertex_array[k] + l] = adjacency[offsets[k] + l].second;
+        }
+    }
+}
+
+void Graph::generate_grid(int num_vertexes, int neighbors_per_vertex, uint64_t seed)
+{
+    static const int offsets_4[][2] = { {-1, 0}, {0, -1}, {0, 1}, {1, 0} };
+    static const int offsets_8[][2] = { {-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1} };
+
+    auto offsets = neighbors_per_vertex >= 8 ? offsets_8 : offsets_4;
+    int number_of_offsets = neighbors_per_vertex >= 8 ? 8 : 4;
+
+    int rows = std::max(1, static_cast<int>(std::sqrt(static_cast<double>(num_vertexes))));
+    int columns = (num_vertexes + rows - 1) / rows;
+
+    // Neighbours of vertex k in the grid; with `edges` == nullptr only count them.
+    // Both directions of a street get the same weight, drawn from the stream
+    // of the unordered vertex pair.
+    auto neighbours = [&](int k, int *edges, float *weights) -> int
+    {
+        int row = k / columns;
+        int column = k % columns;
+        int count = 0;
+
+        for (int i = 0; i < number_of_offsets; ++i)
+        {
+            int r = row + offsets[i][0];
+            int c = column + offsets[i][1];
+            if (r < 0 || r >= rows || c < 0 || c >= columns || r * columns + c >= num_vertexes)
+            {
+                continue;
+            }
+
+            if (edges != nullptr)
+            {
+                int v = r * columns + c;
+                CounterRng rng(seed, static_cast<uint64_t>(std::min(k, v)) * num_vertexes + std::max(k, v));
+                edges[count] = v;
+                weights[count] = random_weight(rng);
+            }
+            ++count;
+        }
+        return count;
+    };
+
+    std::vector<int> degrees(num_vertexes);
+
+    #pragma omp parallel for schedule(static)
+    for (int k = 0; k < num_vertexes; ++k)
+    {
+        degrees[k] = neighbours(k, nullptr, nullptr);
+    }
+
+    auto number_of_edges = degrees_to_offsets(degrees, this->vertex_array);
+    this->edge_array.resize(number_of_edges);
+    this->weight_array.resize(number_of_edges);
+
+    #pragma omp parallel for schedule(static)
+    for (int k = 0; k < num_vertexes; ++k)
+    {
+        neighbours(k, this->edge_array.data() + this->vertex_array[k], this->weight_array.data() + this->vertex_array[k]);
+    }
+}
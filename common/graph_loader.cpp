@@ -0,0 +1,416 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <utility>
+#include <omp.h>
+
+#include "graph.hpp"
+
+// Bytes of text read (and parsed in parallel) at once
+#define LOADER_CHUNK_SIZE (64 << 20)
+
+struct LoadedEdge
+{
+    int from;
+    int to;
+    float weight;
+};
+
+struct LoaderState
+{
+    bool dimacs;
+    bool undirected;
+    long long declared_vertices;   // from the DIMACS "p sp n m" line
+    long long malformed_lines;
+};
+
+static inline const char *skip_blanks(const char *pos, const char *end)
+{
+    while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r'))
+    {
+        ++pos;
+    }
+    return pos;
+}
+
+static inline const char *parse_integer(const char *pos, const char *end, long long &value)
+{
+    pos = skip_blanks(pos, end);
+
+    value = -1;
+    if (pos == end || *pos < '0' || *pos > '9')
+    {
+        return pos;
+    }
+
+    // Saturate above INT_MAX: such ids are rejected by the caller anyway
+    value = 0;
+    while (pos < end && *pos >= '0' && *pos <= '9')
+    {
+        if (value <= INT_MAX)
+        {
+            value = value * 10 + (*pos - '0');
+        }
+        ++pos;
+    }
+    return pos;
+}
+
+///
+/// Parse the weight token at `pos`.  Returns false if the token is not a
+/// number or the weight is negative, NaN or infinite.
+///
+static inline bool parse_weight(const char *pos, const char *end, float &weight)
+{
+    auto token_end = pos;
+    while (token_end < end && *token_end != ' ' && *token_end != '\t' && *token_end != '\r')
+    {
+        ++token_end;
+    }
+
+    // The chunk is not null-terminated, parse a copy of the token
+    std::string token(pos, token_end);
+    char *parsed = nullptr;
+    weight = std::strtof(token.c_str(), &parsed);
+    return parsed == token.c_str() + token.size() && std::isfinite(weight) && weight >= 0.f;
+}
+
+///
+/// Parse the complete lines in [begin, end) and append the edges to `edges`.
+/// Vertex ids are converted to 0-based.
+///
+static void parse_lines(const char *begin, const char *end, LoaderState &state,
+                        std::vector<LoadedEdge> &edges, long long &declared_vertices, long long &malformed_lines)
+{
+    auto pos = begin;
+    while (pos < end)
+    {
+        auto line_end = std::find(pos, end, '\n');
+        pos = skip_blanks(pos, line_end);
+
+        if (pos == line_end)
+        {
+            pos = line_end + 1;
+            continue;
+        }
+
+        long long from, to;
+        const char *cursor;
+
+        if (state.dimacs)
+        {
+            if (*pos == 'p')
+            {
+                // "p sp <vertices> <edges>"
+                cursor = skip_blanks(pos + 1, line_end);
+                while (cursor < line_end && *cursor != ' ' && *cursor != '\t')
+                {
+                    ++cursor;
+                }
+                parse_integer(cursor, line_end, declared_vertices);
+                pos = line_end + 1;
+                continue;
+            }
+            if (*pos != 'a')
+            {
+                pos = line_end + 1;
+                continue;
+            }
+            cursor = pos + 1;
+        }
+        else
+        {
+            if (*pos == '#' || *pos == '%')
+            {
+                pos = line_end + 1;
+                continue;
+            }
+            cursor = pos;
+        }
+
+        cursor = parse_integer(cursor, line_end, from);
+        cursor = parse_integer(cursor, line_end, to);
+
+        if (state.dimacs)
+        {
+            from -= 1;
+            to -= 1;
+        }
+
+        // Ids must fit an int and leave room for the vertex count
+        if (from < 0 || to < 0 || from > INT_MAX - 1 || to > INT_MAX - 1)
+        {
+            ++malformed_lines;
+            pos = line_end + 1;
+            continue;
+        }
+
+        // Weight column, mandatory in DIMACS, optional in SNAP
+        float weight = 1.f;
+        cursor = skip_blanks(cursor, line_end);
+        if (cursor < line_end)
+        {
+            if (!parse_weight(cursor, line_end, weight))
+            {
+                ++malformed_lines;
+                pos = line_end + 1;
+                continue;
+            }
+        }
+        else if (state.dimacs)
+        {
+            ++malformed_lines;
+            pos = line_end + 1;
+            continue;
+        }
+
+        edges.push_back(LoadedEdge{static_cast<int>(from), static_cast<int>(to), weight});
+        pos = line_end + 1;
+    }
+}
+
+///
+/// Read the file chunk by chunk, parse every chunk with all threads and hand
+/// the per-thread edge buffers to `sink`.  Returns false if the file cannot be read.
+///
+static bool stream_edges(const std::string &path, LoaderState &state,
+                         const std::function<void(const std::vector<std::vector<LoadedEdge>> &)> &sink)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open file for reading: " << path << std::endl;
+        return false;
+    }
+
+    auto number_of_threads = omp_get_max_threads();
+    std::vector<std::vector<LoadedEdge>> edges(number_of_threads);
+    std::vector<long long> declared(number_of_threads, -1);
+    std::vector<long long> malformed(number_of_threads, 0);
+
+    std::vector<char> buffer;
+    size_t carried = 0;
+    bool end_of_file = false;
+
+    while (!end_of_file)
+    {
+        // Append a new block after the incomplete line left over from the previous one
+        buffer.resize(carried + LOADER_CHUNK_SIZE);
+        file.read(buffer.data() + carried, LOADER_CHUNK_SIZE);
+        auto length = carried + static_cast<size_t>(file.gcount());
+        end_of_file = !file;
+
+        size_t complete = length;
+        if (!end_of_file)
+        {
+            auto last_newline = std::find(buffer.rbegin() + (buffer.size() - length), buffer.rend(), '\n');
+            complete = buffer.rend() - last_newline;
+        }
+
+        const char *text = buffer.data();
+
+        #pragma omp parallel num_threads(number_of_threads)
+        {
+            auto thread_id = omp_get_thread_num();
+            auto number_of_slices = omp_get_num_threads();
+
+            // Slice boundaries are moved forward to the next line start
+            auto slice_start = [&](int slice) -> size_t
+            {
+                if (slice == 0)
+                {
+                    return 0;
+                }
+                if (slice == number_of_slices)
+                {
+                    return complete;
+                }
+                auto pos = complete * slice / number_of_slices;
+                auto newline = std::find(text + pos, text + complete, '\n');
+                return newline == text + complete ? complete : newline - text + 1;
+            };
+
+            edges[thread_id].clear();
+            auto begin = slice_start(thread_id);
+            auto end = slice_start(thread_id + 1);
+            if (begin < end)
+            {
+                parse_lines(text + begin, text + end, state, edges[thread_id], declared[thread_id], malformed[thread_id]);
+            }
+        }
+
+        sink(edges);
+
+        // Keep the incomplete last line for the next block
+        std::copy(buffer.begin() + complete, buffer.begin() + length, buffer.begin());
+        carried = length - complete;
+    }
+
+    state.declared_vertices = *std::max_element(declared.begin(), declared.end());
+    state.malformed_lines = 0;
+    for (auto count : malformed)
+    {
+        state.malformed_lines += count;
+    }
+    return true;
+}
+
+static bool load_edge_list(const std::string &path, LoaderState &state, CsrArray<int> &vertex_array,
+                           CsrArray<int> &edge_array, CsrArray<float> &weight_array)
+{
+    // --- Pass 1: number of vertices and out-degrees
+    std::vector<int> degrees;
+
+    auto counted = stream_edges(path, state, [&](const std::vector<std::vector<LoadedEdge>> &edges)
+    {
+        int max_vertex = -1;
+        for (const auto &thread_edges : edges)
+        {
+            for (const auto &edge : thread_edges)
+            {
+                max_vertex = std::max(max_vertex, std::max(edge.from, edge.to));
+            }
+        }
+        if (max_vertex >= static_cast<int>(degrees.size()))
+        {
+            degrees.resize(max_vertex + 1, 0);
+        }
+
+        #pragma omp parallel for schedule(static, 1)
+        for (auto t = 0ULL; t < edges.size(); ++t)
+        {
+            for (const auto &edge : edges[t])
+            {
+                #pragma omp atomic
+                degrees[edge.from]++;
+
+                if (state.undirected)
+                {
+                    #pragma omp atomic
+                    degrees[edge.to]++;
+                }
+            }
+        }
+    });
+
+    if (!counted)
+    {
+        return false;
+    }
+
+    if (state.malformed_lines > 0)
+    {
+        std::cerr << "Skipped " << state.malformed_lines << " malformed lines in " << path << std::endl;
+    }
+
+    if (state.declared_vertices > static_cast<long long>(degrees.size()))
+    {
+        degrees.resize(state.declared_vertices, 0);
+    }
+
+    auto number_of_vertexes = static_cast<int>(degrees.size());
+    vertex_array.resize(number_of_vertexes);
+    long long number_of_edges = 0;
+    for (int v = 0; v < number_of_vertexes; ++v)
+    {
+        vertex_array[v] = static_cast<int>(number_of_edges);
+        number_of_edges += degrees[v];
+    }
+    edge_array.resize(number_of_edges);
+    weight_array.resize(number_of_edges);
+
+    // --- Pass 2: counting-sort scatter straight into the CSR arrays
+    std::vector<int> cursor(vertex_array.begin(), vertex_array.end());
+
+    auto scatter = [&](int from, int to, float weight)
+    {
+        int slot;
+        #pragma omp atomic capture
+        slot = cursor[from]++;
+
+        // Guard against the file growing between the passes
+        if (slot < vertex_array[from] + degrees[from])
+        {
+            edge_array[slot] = to;
+            weight_array[slot] = weight;
+        }
+    };
+
+    stream_edges(path, state, [&](const std::vector<std::vector<LoadedEdge>> &edges)
+    {
+        #pragma omp parallel for schedule(static, 1)
+        for (auto t = 0ULL; t < edges.size(); ++t)
+        {
+            for (const auto &edge : edges[t])
+            {
+                if (edge.from >= number_of_vertexes || edge.to >= number_of_vertexes)
+                {
+                    continue;
+                }
+                scatter(edge.from, edge.to, edge.weight);
+                if (state.undirected)
+                {
+                    scatter(edge.to, edge.from, edge.weight);
+                }
+            }
+        }
+    });
+
+    // The scatter order depends on thread timing, sort every row to make the
+    // CSR arrays reproducible
+    #pragma omp parallel
+    {
+        std::vector<std::pair<int, float>> row;
+
+        #pragma omp for schedule(dynamic, 1024)
+        for (int v = 0; v < number_of_vertexes; ++v)
+        {
+            auto first = vertex_array[v];
+            row.clear();
+            for (auto edge = first; edge < first + degrees[v]; ++edge)
+            {
+                row.push_back(std::make_pair(edge_array[edge], weight_array[edge]));
+            }
+            std::sort(row.begin(), row.end());
+            for (auto i = 0ULL; i < row.size(); ++i)
+            {
+                edge_array[first + i] = row[i].first;
+                weight_array[first + i] = row[i].second;
+            }
+        }
+    }
+
+    return true;
+}
+
+Graph Graph::FromDimacs(const std::string &path, graph_storage_t storage)
+{
+    LoaderState state = { true, false, -1, 0 };
+
+    Graph graph;
+    if (!load_edge_list(path, state, graph.vertex_array, graph.edge_array, graph.weight_array))
+    {
+        return Graph();
+    }
+    graph.neighbors_per_vertex = graph.vertex_array.empty() ? 0 : graph.edge_array.size() / graph.vertex_array.size();
+    graph.finish_construction(storage);
+    return graph;
+}
+
+Graph Graph::FromSnap(const std::string &path, bool undirected, graph_storage_t storage)
+{
+    LoaderState state = { false, undirected, -1, 0 };
+
+    Graph graph;
+    if (!load_edge_list(path, state, graph.vertex_array, graph.edge_array, graph.weight_array))
+    {
+        return Graph();
+    }
+    graph.neighbors_per_vertex = graph.vertex_array.empty() ? 0 : graph.edge_array.size() / graph.vertex_array.size();
+    graph.finish_construction(storage);
+    return graph;
+}
@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <numeric>
+#include <omp.h>
+
+#include "graph.hpp"
+
+///
+/// Breadth-first order over the out-edges, restarted from the lowest
+/// unvisited id for every part the previous searches did not reach.  With
+/// `by_degree` the neighbours are visited in increasing degree and every
+/// search starts from the unvisited vertex of lowest degree (Cuthill-McKee).
+///
+static std::vector<int> breadth_first_order(const Graph &graph, bool by_degree)
+{
+    auto number_of_vertexes = static_cast<int>(graph.vertex_array.size());
+    auto degree = [&graph](int v) { return graph.EdgesEnd(v) - graph.EdgesBegin(v); };
+
+    // Candidate roots, in the order they are tried
+    std::vector<int> roots(number_of_vertexes);
+    std::iota(roots.begin(), roots.end(), 0);
+    if (by_degree)
+    {
+        std::stable_sort(roots.begin(), roots.end(), [&degree](int a, int b) { return degree(a) < degree(b); });
+    }
+
+    std::vector<int> order;
+    order.reserve(number_of_vertexes);
+    std::vector<bool> visited(number_of_vertexes, false);
+    std::vector<int> neighbours;
+
+    for (auto root : roots)
+    {
+        if (visited[root])
+        {
+            continue;
+        }
+
+        visited[root] = true;
+        order.push_back(root);
+        // `order` doubles as the queue, [head, size) is the current frontier
+        for (auto head = order.size() - 1; head < order.size(); ++head)
+        {
+            auto u = order[head];
+
+            neighbours.clear();
+            auto edge_end = graph.EdgesEnd(u);
+            for (auto edge = graph.EdgesBegin(u); edge < edge_end; ++edge)
+            {
+                auto v = graph.edge_array[edge];
+                if (!visited[v])
+                {
+                    visited[v] = true;
+                    neighbours.push_back(v);
+                }
+            }
+
+            if (by_degree)
+            {
+                std::stable_sort(neighbours.begin(), neighbours.end(),
+                                 [&degree](int a, int b) { return degree(a) < degree(b); });
+            }
+            order.insert(order.end(), neighbours.begin(), neighbours.end());
+        }
+    }
+
+    return order;
+}
+
+Graph Graph::Reordered(graph_ordering_t ordering) const
+{
+    auto number_of_vertexes = static_cast<int>(this->vertex_array.size());
+
+    // order[new id] = id in this graph
+    std::vector<int> order;
+    switch (ordering)
+    {
+        case GRAPH_ORDERING_BFS:
+            order = breadth_first_order(*this, false);
+            break;
+        case GRAPH_ORDERING_RCM:
+            order = breadth_first_order(*this, true);
+            std::reverse(order.begin(), order.end());
+            break;
+        case GRAPH_ORDERING_DEGREE:
+            // Hubs first: their rows and distances share the first cache lines
+            order.resize(number_of_vertexes);
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [this](int a, int b)
+            {
+                return this->EdgesEnd(a) - this->EdgesBegin(a) > this->EdgesEnd(b) - this->EdgesBegin(b);
+            });
+            break;
+    }
+
+    std::vector<int> rank(number_of_vertexes);
+    for (auto v = 0; v < number_of_vertexes; ++v)
+    {
+        rank[order[v]] = v;
+    }
+
+    Graph result;
+    result.neighbors_per_vertex = this->neighbors_per_vertex;
+    result.vertex_array = CsrArray<int>(number_of_vertexes);
+    result.edge_array = CsrArray<int>(this->edge_array.size());
+    result.weight_array = CsrArray<float>(this->weight_array.size());
+
+    auto offset = 0;
+    for (auto v = 0; v < number_of_vertexes; ++v)
+    {
+        result.vertex_array[v] = offset;
+        offset += this->EdgesEnd(order[v]) - this->EdgesBegin(order[v]);
+    }
+
+    // Rows in the new order, every row sorted by the new target ids so that a
+    // relaxation walks the distance array forward
+    #pragma omp parallel
+    {
+        std::vector<std::pair<int, float>> row;
+
+        #pragma omp for schedule(dynamic, 256)
+        for (auto v = 0; v < number_of_vertexes; ++v)
+        {
+            row.clear();
+            auto edge_end = this->EdgesEnd(order[v]);
+            for (auto edge = this->EdgesBegin(order[v]); edge < edge_end; ++edge)
+            {
+                row.emplace_back(rank[this->edge_array[edge]], this->weight_array[edge]);
+            }
+            std::sort(row.begin(), row.end());
+
+            auto slot = result.vertex_array[v];
+            for (const auto &entry : row)
+            {
+                result.edge_array[slot] = entry.first;
+                result.weight_array[slot] = entry.second;
+                ++slot;
+            }
+        }
+    }
+
+    // Compose with an earlier renumbering, the ids stay relative to the graph
+    // the results are reported for
+    result.original_ids.resize(number_of_vertexes);
+    result.internal_ids.resize(number_of_vertexes);
+    for (auto v = 0; v < number_of_vertexes; ++v)
+    {
+        auto original = this->OriginalId(order[v]);
+        result.original_ids[v] = original;
+        result.internal_ids[original] = v;
+    }
+
+    result.finish_construction(this->HasWeightMatrix() ? GRAPH_STORAGE_DENSE : GRAPH_STORAGE_SPARSE);
+    return result;
+}
+
+std::vector<float> Graph::ToOriginalOrder(const std::vector<float> &distances) const
+{
+    if (!this->IsReordered())
+    {
+        return distances;
+    }
+
+    std::vector<float> original(distances.size());
+    #pragma omp parallel for
+    for (auto v = 0LL; v < static_cast<long long>(distances.size()); ++v)
+    {
+        original[this->original_ids[v]] = distances[v];
+    }
+    return original;
+}
+
+std::vector<int> Graph::ParentsToOriginalOrder(const std::vector<int> &parents) const
+{
+    if (!this->IsReordered())
+    {
+        return parents;
+    }
+
+    std::vector<int> original(parents.size());
+    #pragma omp parallel for
+    for (auto v = 0LL; v < static_cast<long long>(parents.size()); ++v)
+    {
+        // Negative entries mean "no parent" and stay as they are
+        original[this->original_ids[v]] = parents[v] < 0 ? parents[v] : this->original_ids[parents[v]];
+    }
+    return original;
+}
@@ -0,0 +1,296 @@
+#include <climits>
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+#include <omp.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "graph.hpp"
+#include "random.hpp"
+
+///
+/// Snapshot layout (native byte order, checked through `byte_order`):
+///
+///     SnapshotHeader                      at offset 0
+///     int   vertex_array[num_vertices]    at vertex_offset
+///     int   edge_array[num_edges]         at edge_offset
+///     float weight_array[num_edges]       at weight_offset
+///
+/// Every array starts at a multiple of `alignment` (4096 when written) so that it
+/// can be used in place from a mapping of the file.
+///
+#define SNAPSHOT_MAGIC "DJKCSR\0"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_ALIGNMENT 4096
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+// Bytes hashed per block; the block hashes are combined in order
+#define SNAPSHOT_CHECKSUM_BLOCK (1 << 20)
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t header_size;
+    uint32_t alignment;
+    uint64_t num_vertices;
+    uint64_t num_edges;
+    uint64_t vertex_offset;
+    uint64_t edge_offset;
+    uint64_t weight_offset;
+    uint64_t file_size;
+    uint64_t checksum;
+    int32_t neighbors_per_vertex;
+    uint32_t reserved;
+};
+
+static uint64_t align_up(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Whether `count` elements of `element_size` bytes from `offset` end at or
+// before `limit`, without overflowing; `end` is set to their end
+static bool region_fits(uint64_t offset, uint64_t count, uint64_t element_size, uint64_t limit, uint64_t &end)
+{
+    if (offset > limit || count > (limit - offset) / element_size)
+    {
+        return false;
+    }
+    end = offset + count * element_size;
+    return true;
+}
+
+///
+/// The whole file is mapped at offset 0, so the arrays only need the
+/// alignment of their elements, not of a page: any power of two from
+/// alignof(float) up is accepted, whatever the page size of the host
+///
+static bool alignment_valid(uint64_t alignment)
+{
+    return alignment >= alignof(float) && (alignment & (alignment - 1)) == 0;
+}
+
+///
+/// Whether the header describes regions that lie in order inside the file,
+/// each at a multiple of the alignment, with counts the int-indexed CSR
+/// arrays can address
+///
+static bool header_regions_valid(const SnapshotHeader &header)
+{
+    uint64_t vertex_end, edge_end, weight_end;
+    return header.num_vertices <= INT_MAX && header.num_edges <= INT_MAX &&
+           header.vertex_offset >= sizeof(SnapshotHeader) &&
+           header.vertex_offset % header.alignment == 0 && header.edge_offset % header.alignment == 0 &&
+           header.weight_offset % header.alignment == 0 &&
+           region_fits(header.vertex_offset, header.num_vertices, sizeof(int), header.file_size, vertex_end) &&
+           vertex_end <= header.edge_offset &&
+           region_fits(header.edge_offset, header.num_edges, sizeof(int), header.file_size, edge_end) &&
+           edge_end <= header.weight_offset &&
+           region_fits(header.weight_offset, header.num_edges, sizeof(float), header.file_size, weight_end);
+}
+
+///
+/// O(V + E) check that the arrays form a CSR graph the engines can walk:
+/// row offsets start at 0, never decrease and stay within the edges, every
+/// edge target is a vertex
+///
+static bool arrays_valid(const int *vertices, long long num_vertices, const int *edges, long long num_edges)
+{
+    if (num_vertices > 0 && vertices[0] != 0)
+    {
+        return false;
+    }
+
+    auto valid = true;
+
+    #pragma omp parallel for reduction(&& : valid)
+    for (long long v = 0; v < num_vertices; ++v)
+    {
+        auto next = v + 1 < num_vertices ? static_cast<long long>(vertices[v + 1]) : num_edges;
+        valid = valid && vertices[v] <= next && next <= num_edges;
+    }
+
+    #pragma omp parallel for reduction(&& : valid)
+    for (long long edge = 0; edge < num_edges; ++edge)
+    {
+        valid = valid && edges[edge] >= 0 && edges[edge] < num_vertices;
+    }
+
+    return valid;
+}
+
+///
+/// Block-parallel hash of a byte range: every block is hashed 8 bytes at a
+/// time and the block hashes are chained in order, so the result does not
+/// depend on the number of threads.
+///
+static uint64_t checksum_bytes(const unsigned char *bytes, uint64_t size, uint64_t seed)
+{
+    auto number_of_blocks = static_cast<long long>((size + SNAPSHOT_CHECKSUM_BLOCK - 1) / SNAPSHOT_CHECKSUM_BLOCK);
+    std::vector<uint64_t> block_hashes(number_of_blocks);
+
+    #pragma omp parallel for schedule(static)
+    for (long long block = 0; block < number_of_blocks; ++block)
+    {
+        auto first = static_cast<uint64_t>(block) * SNAPSHOT_CHECKSUM_BLOCK;
+        auto last = std::min<uint64_t>(first + SNAPSHOT_CHECKSUM_BLOCK, size);
+
+        uint64_t hash = 0;
+        for (auto pos = first; pos < last; pos += sizeof(uint64_t))
+        {
+            uint64_t word = 0;
+            std::memcpy(&word, bytes + pos, std::min<uint64_t>(sizeof(uint64_t), last - pos));
+            hash = CounterRng::mix(hash ^ word) + pos;
+        }
+        block_hashes[block] = hash;
+    }
+
+    auto hash = seed;
+    for (auto block_hash : block_hashes)
+    {
+        hash = CounterRng::mix(hash ^ block_hash);
+    }
+    return CounterRng::mix(hash ^ size);
+}
+
+static uint64_t checksum_arrays(const int *vertices, uint64_t num_vertices,
+                                const int *edges, const float *weights, uint64_t num_edges)
+{
+    auto hash = checksum_bytes(reinterpret_cast<const unsigned char *>(vertices), num_vertices * sizeof(int), 0);
+    hash = checksum_bytes(reinterpret_cast<const unsigned char *>(edges), num_edges * sizeof(int), hash);
+    return checksum_bytes(reinterpret_cast<const unsigned char *>(weights), num_edges * sizeof(float), hash);
+}
+
+static bool write_padded(FILE *file, const void *data, uint64_t size, uint64_t padded_size)
+{
+    static const char zeros[SNAPSHOT_ALIGNMENT] = { 0 };
+
+    if (size > 0 && fwrite(data, 1, size, file) != size)
+    {
+        return false;
+    }
+    for (auto left = padded_size - size; left > 0; )
+    {
+        auto chunk = std::min<uint64_t>(left, sizeof(zeros));
+        if (fwrite(zeros, 1, chunk, file) != chunk)
+        {
+            return false;
+        }
+        left -= chunk;
+    }
+    return true;
+}
+
+bool Graph::SaveSnapshot(const std::string &path) const
+{
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.header_size = sizeof(SnapshotHeader);
+    header.alignment = SNAPSHOT_ALIGNMENT;
+    header.num_vertices = this->vertex_array.size();
+    header.num_edges = this->edge_array.size();
+    header.vertex_offset = align_up(sizeof(SnapshotHeader), SNAPSHOT_ALIGNMENT);
+    header.edge_offset = align_up(header.vertex_offset + header.num_vertices * sizeof(int), SNAPSHOT_ALIGNMENT);
+    header.weight_offset = align_up(header.edge_offset + header.num_edges * sizeof(int), SNAPSHOT_ALIGNMENT);
+    header.file_size = align_up(header.weight_offset + header.num_edges * sizeof(float), SNAPSHOT_ALIGNMENT);
+    header.checksum = checksum_arrays(this->vertex_array.data(), header.num_vertices,
+                                      this->edge_array.data(), this->weight_array.data(), header.num_edges);
+    header.neighbors_per_vertex = this->neighbors_per_vertex;
+
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        std::cerr << "Failed to open file for writing: " << path << std::endl;
+        return false;
+    }
+
+    auto written = write_padded(file, &header, sizeof(header), header.vertex_offset) &&
+                   write_padded(file, this->vertex_array.data(), header.num_vertices * sizeof(int),
+                                header.edge_offset - header.vertex_offset) &&
+                   write_padded(file, this->edge_array.data(), header.num_edges * sizeof(int),
+                                header.weight_offset - header.edge_offset) &&
+                   write_padded(file, this->weight_array.data(), header.num_edges * sizeof(float),
+                                header.file_size - header.weight_offset);
+
+    if (fclose(file) != 0 || !written)
+    {
+        std::cerr << "Failed to write snapshot: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+Graph Graph::FromSnapshot(const std::string &path, bool verify, graph_storage_t storage)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "Failed to open file for reading: " << path << std::endl;
+        return Graph();
+    }
+
+    struct stat file_info;
+    SnapshotHeader header;
+    if (fstat(fd, &file_info) != 0 || pread(fd, &header, sizeof(header), 0) != sizeof(header))
+    {
+        std::cerr << "Failed to read snapshot header: " << path << std::endl;
+        close(fd);
+        return Graph();
+    }
+
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != SNAPSHOT_VERSION || header.byte_order != SNAPSHOT_BYTE_ORDER ||
+        header.header_size != sizeof(SnapshotHeader) ||
+        !alignment_valid(header.alignment) ||
+        header.file_size != static_cast<uint64_t>(file_info.st_size) || !header_regions_valid(header))
+    {
+        std::cerr << "Not a compatible graph snapshot (version " << SNAPSHOT_VERSION << "): " << path << std::endl;
+        close(fd);
+        return Graph();
+    }
+
+    // A private writable mapping: untouched pages stay shared with the page
+    // cache (and other processes), writes such as weight updates are copy-on-write
+    void *address = mmap(nullptr, header.file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED)
+    {
+        std::cerr << "Failed to map snapshot: " << path << std::endl;
+        return Graph();
+    }
+
+    auto file_size = header.file_size;
+    std::shared_ptr<void> mapping(address, [file_size](void *mapped) { munmap(mapped, file_size); });
+    auto bytes = static_cast<unsigned char *>(address);
+
+    Graph graph;
+    graph.vertex_array.Adopt(reinterpret_cast<int *>(bytes + header.vertex_offset), header.num_vertices, mapping);
+    graph.edge_array.Adopt(reinterpret_cast<int *>(bytes + header.edge_offset), header.num_edges, mapping);
+    graph.weight_array.Adopt(reinterpret_cast<float *>(bytes + header.weight_offset), header.num_edges, mapping);
+    graph.neighbors_per_vertex = header.neighbors_per_vertex;
+
+    if (verify && checksum_arrays(graph.vertex_array.data(), header.num_vertices, graph.edge_array.data(),
+                                  graph.weight_array.data(), header.num_edges) != header.checksum)
+    {
+        std::cerr << "Snapshot checksum mismatch: " << path << std::endl;
+        return Graph();
+    }
+    if (!arrays_valid(graph.vertex_array.data(), static_cast<long long>(header.num_vertices),
+                      graph.edge_array.data(), static_cast<long long>(header.num_edges)))
+    {
+        std::cerr << "Snapshot is not a valid CSR graph: " << path << std::endl;
+        return Graph();
+    }
+
+    graph.finish_construction(storage);
+    return graph;
+}
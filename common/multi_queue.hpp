@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "random.hpp"
+
+///
+/// Relaxed concurrent min-priority queue: a MultiQueue (Rihani, Sanders,
+/// Dementiev) of `queues_per_thread` heaps per thread, each behind its own
+/// spinlock.
+///
+/// A thread pushes into one of its own heaps, so inserts rarely contend.
+/// Pop looks at the cached top of one of its own heaps and of a random heap
+/// of any thread and takes the smaller one: an idle thread or one with worse
+/// work steals from the others.  The result is only approximately the global
+/// minimum, and items may come out several times if they were pushed several
+/// times; the caller skips what is stale.
+///
+template <typename Key>
+class MultiQueue
+{
+    struct Entry
+    {
+        Key key;
+        int item;
+    };
+
+    // Min-heap order for the std heap algorithms
+    struct EntryGreater
+    {
+        bool operator()(const Entry &a, const Entry &b) const { return b.key < a.key; }
+    };
+
+    struct Queue
+    {
+        std::atomic<bool> locked;
+        std::atomic<Key> top;           // EMPTY_KEY when the heap is empty
+        std::vector<Entry> heap;
+        char padding[64];               // keep neighbouring locks off this line
+
+        Queue() : locked(false), top(EMPTY_KEY)
+        {
+        }
+    };
+
+    int queues_per_thread;
+    int number_of_queues;
+    std::unique_ptr<Queue[]> queues;
+
+public:
+    static constexpr Key EMPTY_KEY = std::numeric_limits<Key>::max();
+
+    MultiQueue(int number_of_threads, int queues_per_thread) :
+        queues_per_thread(queues_per_thread),
+        number_of_queues(number_of_threads * queues_per_thread), queues(new Queue[number_of_threads * queues_per_thread])
+    {
+    }
+
+    // Insert into a heap of `thread`
+    void Push(int thread, int item, Key key, CounterRng &rng)
+    {
+        while (true)
+        {
+            auto &queue = this->queues[thread * this->queues_per_thread + rng.NextBounded(this->queues_per_thread)];
+            if (!try_lock(queue))
+            {
+                continue;
+            }
+            queue.heap.push_back(Entry{key, item});
+            std::push_heap(queue.heap.begin(), queue.heap.end(), EntryGreater());
+            queue.top.store(queue.heap.front().key, std::memory_order_relaxed);
+            unlock(queue);
+            return;
+        }
+    }
+
+    // Pop an approximately smallest item; false if every heap `thread` tried
+    // (number_of_queues attempts) was empty
+    bool TryPop(int thread, int &item, Key &key, CounterRng &rng)
+    {
+        for (auto attempt = 0; attempt < this->number_of_queues; ++attempt)
+        {
+            auto &own = this->queues[thread * this->queues_per_thread + rng.NextBounded(this->queues_per_thread)];
+            auto &other = this->queues[rng.NextBounded(this->number_of_queues)];
+
+            auto own_top = own.top.load(std::memory_order_relaxed);
+            auto other_top = other.top.load(std::memory_order_relaxed);
+            auto &queue = other_top < own_top ? other : own;
+            if (EMPTY_KEY == std::min(own_top, other_top) || !try_lock(queue))
+            {
+                continue;
+            }
+
+            // The top may have changed between the peek and the lock
+            if (queue.heap.empty())
+            {
+                unlock(queue);
+                continue;
+            }
+
+            std::pop_heap(queue.heap.begin(), queue.heap.end(), EntryGreater());
+            item = queue.heap.back().item;
+            key = queue.heap.back().key;
+            queue.heap.pop_back();
+            queue.top.store(queue.heap.empty() ? EMPTY_KEY : queue.heap.front().key, std::memory_order_relaxed);
+            unlock(queue);
+            return true;
+        }
+        return false;
+    }
+
+private:
+    static bool try_lock(Queue &queue)
+    {
+        return !queue.locked.load(std::memory_order_relaxed) &&
+               !queue.locked.exchange(true, std::memory_order_acquire);
+    }
+
+    static void unlock(Queue &queue)
+    {
+        queue.locked.store(false, std::memory_order_release);
+    }
+};
+
+template <typename Key>
+constexpr Key MultiQueue<Key>::EMPTY_KEY;
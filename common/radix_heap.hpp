@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+///
+/// Monotone radix heap over unsigned integer keys (Ahuja, Mehlhorn, Orlin,
+/// Tarjan; the one-level variant of Cherkassky, Goldberg, Silverstein).
+///
+/// Keys pushed must not be smaller than the last popped key, which holds for
+/// Dijkstra.  Bucket i holds the keys whose highest bit differing from the
+/// last popped key is bit i - 1 (bucket 0: equal to it).  Popping from an
+/// empty bucket 0 redistributes the first non-empty bucket around its
+/// minimum; every entry moves to a lower bucket each time, so the amortized
+/// cost is O(bits) per entry without any comparisons between keys.
+///
+/// There is no DecreaseKey: push the item again and skip the stale entries.
+///
+template <typename Key>
+class RadixHeap
+{
+    static const int BUCKETS = static_cast<int>(sizeof(Key)) * 8 + 1;
+
+    struct Entry
+    {
+        Key key;
+        int item;
+    };
+
+    std::vector<Entry> buckets[BUCKETS];
+    Key last;
+    size_t count;
+
+public:
+    RadixHeap() : last(0), count(0)
+    {
+    }
+
+    bool Empty() const { return this->count == 0; }
+    size_t Size() const { return this->count; }
+
+    void Push(int item, Key key)
+    {
+        this->buckets[bucket_of(key, this->last)].push_back(Entry{key, item});
+        ++this->count;
+    }
+
+    // Remove an entry with the smallest key; the heap must not be empty
+    void Pop(int &item, Key &key)
+    {
+        if (this->buckets[0].empty())
+        {
+            auto index = 1;
+            while (this->buckets[index].empty())
+            {
+                ++index;
+            }
+
+            auto &bucket = this->buckets[index];
+            auto minimum = bucket[0].key;
+            for (const auto &entry : bucket)
+            {
+                minimum = entry.key < minimum ? entry.key : minimum;
+            }
+
+            this->last = minimum;
+            for (const auto &entry : bucket)
+            {
+                this->buckets[bucket_of(entry.key, minimum)].push_back(entry);
+            }
+            bucket.clear();
+        }
+
+        item = this->buckets[0].back().item;
+        key = this->buckets[0].back().key;
+        this->buckets[0].pop_back();
+        --this->count;
+    }
+
+    // Forget every entry and start again from key 0, keeping the allocations
+    void Clear()
+    {
+        for (auto &bucket : this->buckets)
+        {
+            bucket.clear();
+        }
+        this->last = 0;
+        this->count = 0;
+    }
+
+private:
+    static int bucket_of(Key key, Key last)
+    {
+        auto difference = static_cast<uint64_t>(key ^ last);
+        return difference == 0 ? 0 : 64 - __builtin_clzll(difference);
+    }
+};
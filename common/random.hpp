@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+///
+/// Counter-based random number generator.
+///
+/// Every value is a pure function of (seed, stream, counter): the stream id is
+/// typically a vertex or an edge index, so the numbers a parallel loop iteration
+/// draws do not depend on which thread runs it or in what order.  The mixing
+/// function is the SplitMix64 finalizer applied to a Weyl sequence keyed by the
+/// seed and the stream.
+///
+class CounterRng
+{
+    uint64_t key;
+    uint64_t counter;
+
+public:
+    CounterRng(uint64_t seed, uint64_t stream) : key(mix(seed ^ mix(stream + 0x9E3779B97F4A7C15ULL))), counter(0)
+    {
+    }
+
+    uint64_t Next()
+    {
+        return mix(this->key + (++this->counter) * 0x9E3779B97F4A7C15ULL);
+    }
+
+    // Uniform integer in [0, bound) (multiply-shift, bias below 2^-32 * bound)
+    uint32_t NextBounded(uint32_t bound)
+    {
+        return static_cast<uint32_t>(((this->Next() >> 32) * bound) >> 32);
+    }
+
+    // Uniform double in [0, 1)
+    double NextDouble()
+    {
+        return static_cast<double>(this->Next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    static uint64_t mix(uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
@@ -23,9 +23,10 @@ set style fill transparent solid 0.15 border
 
 set key out
 
-plot "output.dat" using 1:2 title 'Reference' w l,\
-     "output.dat" using 1:3 title 'CPU (OpenMP)' w l, \
-     "output.dat" using 1:4 title 'CPU (OpenCL)' w l, \
-     "output.dat" using 1:5 title 'GPU (OpenCL)' w l, \
-     "output.dat" using 1:6 title 'GPU (CUDA)' w l, \
-     "output.dat" using 1:7 title 'GPU (OpenACC)' w l, \
+# output.csv columns: graph,vertices,edges,degree,seed,backend,prepare_seconds,runs,min,median,p95,mean,stddev,mismatches
+set datafile separator ","
+
+backends = "sequential heap heap-batch heap-compressed heap-int radix-heap dial sequential-csr omp omp-csr omp-hn delta multiqueue opencl-cpu opencl-gpu opencl-cpu-frontier opencl-gpu-frontier cuda acc"
+
+# Median time of every backend; backends missing from the file are skipped
+plot for [backend in backends] "output.csv" using 2:(strcol(6) eq backend ? $10 : 1/0) title backend w l
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+///
+/// Number of iterations the GPU backends queue between two convergence
+/// checks.  After every check the batch is resized from the size of the
+/// frontier: it doubles while the frontier grows or shrinks slowly (fewer
+/// host round trips) and halves once the frontier is about to run out at its
+/// current rate (fewer wasted iterations after convergence).
+///
+class AdaptiveBatch
+{
+    int size;
+    int min_size;
+    int max_size;
+    long long previous_frontier;
+
+public:
+    explicit AdaptiveBatch(int initial_size = 4, int min_size = 1, int max_size = 64) :
+        size(initial_size), min_size(min_size), max_size(max_size), previous_frontier(0)
+    {
+    }
+
+    int Size() const { return this->size; }
+
+    void Update(long long frontier)
+    {
+        if (this->previous_frontier > 0 && frontier < this->previous_frontier)
+        {
+            // Batches left if the frontier keeps shrinking at the same rate
+            auto batches_left = frontier > 1 ? std::log(static_cast<double>(frontier)) /
+                                               std::log(static_cast<double>(this->previous_frontier) / frontier)
+                                             : 0.;
+            if (batches_left < 1.)
+            {
+                this->size = std::max(this->min_size, this->size / 2);
+            }
+            else if (batches_left > 4.)
+            {
+                this->size = std::min(this->max_size, this->size * 2);
+            }
+        }
+        else
+        {
+            this->size = std::min(this->max_size, this->size * 2);
+        }
+        this->previous_frontier = frontier;
+    }
+};
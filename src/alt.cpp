@@ -0,0 +1,149 @@
+#include "src/point_to_point.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include <omp.h>
+
+AltIndex::AltIndex(const Graph &graph, int count, SsspEngine sssp) : count(0), preprocessing_seconds(0.)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    auto number_of_vertexes = static_cast<int>(graph.vertex_array.size());
+
+    // --- Farthest selection.  `closest` is the distance from the nearest
+    // landmark so far; the vertex that maximizes it becomes the next landmark,
+    // and its run is its table.  The first landmark is the vertex farthest
+    // from vertex 0, whose run is only used for that pick.
+    std::vector<std::vector<float>> from_landmarks;
+    std::vector<float> closest = number_of_vertexes > 0 ? sssp(graph, 0) : std::vector<float>();
+    while (static_cast<int>(this->landmarks.size()) < count)
+    {
+        auto farthest = std::max_element(closest.begin(), closest.end());
+        if (farthest == closest.end() || *farthest == 0.f)
+        {
+            // Every vertex is a landmark, or as close to one as a landmark itself
+            break;
+        }
+
+        auto landmark = static_cast<int>(farthest - closest.begin());
+        this->landmarks.push_back(landmark);
+        from_landmarks.push_back(sssp(graph, landmark));
+
+        const auto &distances = from_landmarks.back();
+        if (this->landmarks.size() == 1)
+        {
+            closest = distances;
+        }
+        else
+        {
+            #pragma omp parallel for
+            for (auto v = 0; v < number_of_vertexes; ++v)
+            {
+                closest[v] = std::min(closest[v], distances[v]);
+            }
+        }
+        closest[landmark] = 0.f;
+    }
+    this->count = static_cast<int>(this->landmarks.size());
+
+    // --- Vertex-major tables, the backward runs go straight into them
+    auto stride = 2 * static_cast<size_t>(this->count);
+    this->tables.assign(number_of_vertexes * stride, FLT_MAX);
+    for (auto i = 0; i < this->count; ++i)
+    {
+        auto to_landmark = sssp(graph.Reverse(), this->landmarks[i]);
+        const auto &from_landmark = from_landmarks[i];
+
+        #pragma omp parallel for
+        for (auto v = 0; v < number_of_vertexes; ++v)
+        {
+            this->tables[v * stride + i] = from_landmark[v];
+            this->tables[v * stride + this->count + i] = to_landmark[v];
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    this->preprocessing_seconds = elapsed.count();
+}
+
+AStarSearch::AStarSearch(const Graph &graph, const AltIndex *index) : graph(graph), index(index)
+{
+    auto number_of_vertexes = static_cast<int>(graph.vertex_array.size());
+
+    this->distances.assign(number_of_vertexes, FLT_MAX);
+    this->potentials.assign(number_of_vertexes, FLT_MAX);
+    this->parents.assign(number_of_vertexes, DIJKSTRA_NO_PARENT);
+    this->queue.Resize(number_of_vertexes);
+}
+
+PointToPointResult AStarSearch::Query(int source_vertex, int target_vertex)
+{
+    PointToPointResult result;
+    result.settled = 0;
+
+    // Computed the first time a vertex is reached, then kept for the query
+    auto potential = [this, target_vertex](int v)
+    {
+        if (this->potentials[v] == FLT_MAX)
+        {
+            this->potentials[v] = this->index != nullptr ? this->index->LowerBound(v, target_vertex) : 0.f;
+        }
+        return this->potentials[v];
+    };
+
+    this->distances[source_vertex] = 0.f;
+    this->parents[source_vertex] = source_vertex;
+    this->touched.push_back(source_vertex);
+    this->queue.Push(source_vertex, potential(source_vertex));
+
+    // --- A* iterations, keyed by distance + lower bound to the target
+    while (!this->queue.Empty())
+    {
+        auto current_vertex = this->queue.Pop();
+        ++result.settled;
+        if (current_vertex == target_vertex)
+        {
+            break;
+        }
+
+        auto current_distance = this->distances[current_vertex];
+        auto edge_end = this->graph.EdgesEnd(current_vertex);
+        for (auto edge = this->graph.EdgesBegin(current_vertex); edge < edge_end; ++edge)
+        {
+            auto v = this->graph.edge_array[edge];
+            auto candidate = current_distance + this->graph.weight_array[edge];
+
+            if (candidate < this->distances[v])
+            {
+                if (this->distances[v] == FLT_MAX)
+                {
+                    this->touched.push_back(v);
+                }
+                this->distances[v] = candidate;
+                this->parents[v] = current_vertex;
+                this->queue.PushOrDecrease(v, candidate + potential(v));
+            }
+        }
+    }
+
+    result.distance = this->distances[target_vertex];
+    if (result.distance != FLT_MAX)
+    {
+        for (auto v = target_vertex; v != source_vertex; v = this->parents[v])
+        {
+            result.path.push_back(v);
+        }
+        result.path.push_back(source_vertex);
+        std::reverse(result.path.begin(), result.path.end());
+    }
+
+    for (auto v : this->touched)
+    {
+        this->distances[v] = FLT_MAX;
+        this->potentials[v] = FLT_MAX;
+        this->parents[v] = DIJKSTRA_NO_PARENT;
+    }
+    this->touched.clear();
+    this->queue.Clear();
+    return result;
+}
@@ -0,0 +1,1378 @@
+#include "src/benchmark.hpp"
+#include "src/opencl_engine.hpp"
+#include "src/dynamic_sssp.hpp"
+#include "common/random.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+struct BenchmarkResult
+{
+    std::string graph;
+    size_t vertices;
+    size_t edges;
+    int degree;
+    uint64_t seed;
+    std::string backend;
+    double prepare_seconds;
+    std::vector<double> samples;
+    TimingStats stats;
+    long long mismatches;       // -1 if not validated
+};
+
+// Mismatching vertices printed per backend
+#define VALIDATION_REPORT_LIMIT 10
+// Random pairs on which the contraction hierarchy is timed against bidirectional Dijkstra,
+// and how much faster it has to be to answer the queries
+#define CH_ROUTING_PAIRS 64
+#define CH_ROUTING_MIN_SPEEDUP 1.1
+
+static void print_paths(const std::string& msg, const std::vector<int> &parents, int source_vertex)
+{
+#if ENABLE_PATH_PRINT != 0
+    std::cout << std::endl << msg << ", actual paths:" << std::endl;
+    for (auto k = 0ULL; k < parents.size(); k++)
+    {
+        std::cout << "Path from " << source_vertex << " to " << k << ": ";
+        auto path = dijkstra_path(parents, source_vertex, static_cast<int>(k));
+        if (path.empty())
+        {
+            std::cout << "None" << std::endl;
+            continue;
+        }
+        for (auto j = 0ULL; j + 1 < path.size(); ++j)
+        {
+            std::cout << path[j] << " -> ";
+        }
+        std::cout << k << std::endl;
+    }
+#else
+    (void)msg;
+    (void)parents;
+    (void)source_vertex;
+#endif
+}
+
+static void print_results(const std::string& msg, const std::vector<float> &res, int source_vertex)
+{
+#if PRINT_RESULTS != 0
+    std::cout << std::endl << msg << std::endl;
+    for (auto k = 0ULL; k < res.size(); k++)
+    {
+        std::cout << "From vertex " << source_vertex << " to vertex " << k << " = " << res[k] << std::endl;
+    }
+#else
+    (void)msg;
+    (void)res;
+    (void)source_vertex;
+#endif
+}
+
+static double seconds_since(std::chrono::time_point<std::chrono::high_resolution_clock> start)
+{
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return elapsed.count();
+}
+
+static std::string json_escape(const std::string &value)
+{
+    std::string escaped;
+    for (auto c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+const char *ordering_name(graph_ordering_t ordering)
+{
+    switch (ordering)
+    {
+        case GRAPH_ORDERING_BFS:    return "bfs";
+        case GRAPH_ORDERING_RCM:    return "rcm";
+        case GRAPH_ORDERING_DEGREE: return "degree";
+    }
+    return "unknown";
+}
+
+bool parse_ordering(const std::string &name, graph_ordering_t &ordering)
+{
+    const graph_ordering_t orderings[] = { GRAPH_ORDERING_BFS, GRAPH_ORDERING_RCM, GRAPH_ORDERING_DEGREE };
+    for (auto candidate : orderings)
+    {
+        if (name == ordering_name(candidate))
+        {
+            ordering = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *topology_name(graph_topology_t topology)
+{
+    switch (topology)
+    {
+        case GRAPH_TOPOLOGY_UNIFORM:     return "uniform";
+        case GRAPH_TOPOLOGY_ERDOS_RENYI: return "erdos-renyi";
+        case GRAPH_TOPOLOGY_RMAT:        return "rmat";
+        case GRAPH_TOPOLOGY_GRID:        return "grid";
+    }
+    return "unknown";
+}
+
+bool parse_topology(const std::string &name, graph_topology_t &topology)
+{
+    const graph_topology_t topologies[] = { GRAPH_TOPOLOGY_UNIFORM, GRAPH_TOPOLOGY_ERDOS_RENYI,
+                                            GRAPH_TOPOLOGY_RMAT, GRAPH_TOPOLOGY_GRID };
+    for (auto candidate : topologies)
+    {
+        if (name == topology_name(candidate))
+        {
+            topology = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+TimingStats compute_stats(std::vector<double> samples)
+{
+    TimingStats stats = { static_cast<int>(samples.size()), 0., 0., 0., 0., 0., 0. };
+    if (samples.empty())
+    {
+        return stats;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto count = samples.size();
+
+    stats.min = samples.front();
+    stats.median = count % 2 ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) / 2.;
+    // Nearest-rank percentile
+    stats.p95 = samples[static_cast<size_t>(std::ceil(0.95 * count)) - 1];
+    stats.p99 = samples[static_cast<size_t>(std::ceil(0.99 * count)) - 1];
+
+    for (auto sample : samples)
+    {
+        stats.mean += sample;
+    }
+    stats.mean /= count;
+
+    if (count > 1)
+    {
+        double sum_of_squares = 0.;
+        for (auto sample : samples)
+        {
+            sum_of_squares += (sample - stats.mean) * (sample - stats.mean);
+        }
+        stats.stddev = std::sqrt(sum_of_squares / (count - 1));
+    }
+    return stats;
+}
+
+///
+/// Derived copy of the benchmarked graph (compressed, integer weights, ...),
+/// built in `prepare`, outside of the timed runs, and kept until the graph
+/// changes
+///
+template <typename T>
+class GraphCopy
+{
+    uint64_t revision;
+    std::unique_ptr<T> copy;
+    std::function<T *(const Graph &)> build;
+
+public:
+    // `build` makes the copy of a graph, T(graph) by default
+    explicit GraphCopy(std::function<T *(const Graph &)> build = &GraphCopy::construct) : revision(0), build(build)
+    {
+    }
+
+    T &For(const Graph &graph)
+    {
+        if (this->copy == nullptr || this->revision != graph.Revision())
+        {
+            this->copy.reset(this->build(graph));
+            this->revision = graph.Revision();
+        }
+        return *this->copy;
+    }
+
+    // The copy of the last graph, For() must have been called
+    const T &Last() const { return *this->copy; }
+
+private:
+    static T *construct(const Graph &graph) { return new T(graph); }
+};
+
+static std::vector<float> to_float_distances(const std::vector<IntegerDistance> &distances, double weight_scale)
+{
+    std::vector<float> result(distances.size());
+    for (auto v = 0ULL; v < distances.size(); ++v)
+    {
+        result[v] = distances[v] == INTEGER_DISTANCE_INFINITY ? FLT_MAX
+                                                              : static_cast<float>(distances[v] / weight_scale);
+    }
+    return result;
+}
+
+std::vector<Backend> available_backends(const BackendConfig &config)
+{
+    std::vector<Backend> backends;
+
+    // The matrix engines read the dense weight matrix, build it before timing
+    auto build_weight_matrix = [](const Graph &graph) { graph.WeightMatrix(); };
+
+    backends.push_back(Backend{"sequential", "Reference O(V^2) Dijkstra over the weight matrix",
+                               build_weight_matrix, dijkstra_sequential});
+    backends.push_back(Backend{"sequential-csr", "O(V^2) Dijkstra relaxing through the CSR arrays",
+                               nullptr, dijkstra_sequential_csr});
+    backends.push_back(Backend{"heap", "Dijkstra with an indexed 4-ary heap over the CSR arrays",
+                               nullptr, dijkstra_sequential_heap});
+    backends.back().batch = dijkstra_batch;
+
+    auto compressed = std::make_shared<GraphCopy<CompressedGraph>>();
+    backends.push_back(Backend{"heap-compressed", "The heap engine over varint-encoded rows and uint16 weights",
+                               [compressed](const Graph &graph) { compressed->For(graph); },
+                               [compressed](const Graph &graph, int source_vertex, std::vector<int> *parents)
+                               {
+                                   return dijkstra_compressed_heap(compressed->For(graph), source_vertex, parents);
+                               },
+                               [compressed]()
+                               {
+                                   const auto &graph = compressed->Last();
+                                   std::ostringstream report;
+                                   report << std::fixed << std::setprecision(2) << "footprint "
+                                          << graph.Bytes() / 1048576. << " MiB, CSR arrays "
+                                          << graph.CsrBytes() / 1048576. << " MiB ("
+                                          << 100. * graph.Bytes() / std::max<size_t>(graph.CsrBytes(), 1)
+                                          << "%), weights " << (graph.IsLossless() ? "lossless" : "lossy")
+                                          << " at scale " << graph.WeightScale();
+                                   return report.str();
+                               }});
+
+    // The integer engines return exact integer distances, converted back to
+    // float (inside the timed run) for the comparison with the other backends
+    typedef std::vector<IntegerDistance> (*IntegerEngine)(const IntegerGraph &, int, std::vector<int> *);
+    struct IntegerBackend
+    {
+        const char *name;
+        const char *description;
+        IntegerEngine engine;
+    };
+    const IntegerBackend integer_backends[] = {
+        { "heap-int", "The heap engine over uint32 weights and uint64 distances", dijkstra_integer_heap },
+        { "radix-heap", "Dijkstra with a monotone radix heap over uint32 weights", dijkstra_radix_heap },
+        { "dial", "Dial's algorithm, one bucket per distance modulo the largest uint32 weight", dijkstra_dial },
+    };
+
+    auto integer_graph = std::make_shared<GraphCopy<IntegerGraph>>();
+    auto integer_report = [integer_graph]()
+    {
+        const auto &graph = integer_graph->Last();
+        std::ostringstream report;
+        report << "weights x" << graph.WeightScale() << (graph.IsLossless() ? " lossless" : " lossy")
+               << ", largest " << graph.MaxWeight();
+        return report.str();
+    };
+    for (const auto &integer_backend : integer_backends)
+    {
+        auto engine = integer_backend.engine;
+        backends.push_back(Backend{integer_backend.name, integer_backend.description,
+                                   [integer_graph](const Graph &graph) { integer_graph->For(graph); },
+                                   [integer_graph, engine](const Graph &graph, int source_vertex, std::vector<int> *parents)
+                                   {
+                                       const auto &integer = integer_graph->For(graph);
+                                       return to_float_distances(engine(integer, source_vertex, parents),
+                                                                 integer.WeightScale());
+                                   },
+                                   integer_report});
+    }
+
+    backends.push_back(Backend{"omp", "\"Naive\" OpenMP Dijkstra over the weight matrix",
+                               build_weight_matrix, dijkstra_omp});
+    backends.push_back(Backend{"omp-csr", "\"Naive\" OpenMP Dijkstra relaxing through the CSR arrays",
+                               nullptr, dijkstra_omp_csr});
+
+    auto delta = config.delta;
+    backends.push_back(Backend{"delta", "Delta-stepping on OpenMP", nullptr,
+                               [delta](const Graph &graph, int source_vertex, std::vector<int> *parents)
+                               {
+                                   return delta > 0.f ? dijkstra_delta_stepping(graph, source_vertex, delta, parents)
+                                                      : dijkstra_delta_stepping(graph, source_vertex, parents);
+                               }});
+    auto multiqueue_stats = std::make_shared<MultiQueueStats>();
+    backends.push_back(Backend{"multiqueue", "Asynchronous SSSP over a MultiQueue with work stealing", nullptr,
+                               [multiqueue_stats](const Graph &graph, int source_vertex, std::vector<int> *parents)
+                               {
+                                   return dijkstra_multiqueue(graph, source_vertex, parents, multiqueue_stats.get());
+                               },
+                               [multiqueue_stats]()
+                               {
+                                   const auto &stats = *multiqueue_stats;
+                                   std::ostringstream report;
+                                   report << "wasted work " << stats.WastedWork() << " ("
+                                          << stats.stale_pops << " stale pops, "
+                                          << stats.expansions - stats.reached << " repeated expansions, "
+                                          << stats.reached << " vertices reached)";
+                                   return report.str();
+                               }});
+    backends.push_back(Backend{"omp-hn", "Harish-Narayanan algorithm on OpenMP threads with a sparse frontier",
+                               nullptr, dijkstra_harish_narayanan});
+
+    if (config.batch_sources > 0)
+    {
+        auto batch_sources = config.batch_sources;
+        std::ostringstream description;
+        description << "dijkstra_batch over " << batch_sources << " sources (the first is --source, "
+                    << "the rest spread evenly over the vertices)";
+
+        backends.push_back(Backend{"heap-batch", description.str(), nullptr,
+                                   [batch_sources](const Graph &graph, int source_vertex, std::vector<int> *parents)
+                                   {
+                                       auto number_of_vertexes = graph.vertex_array.size();
+                                       std::vector<int> sources(1, source_vertex);
+                                       for (int i = 1; i < batch_sources; ++i)
+                                       {
+                                           sources.push_back(static_cast<int>(i * number_of_vertexes / batch_sources));
+                                       }
+
+                                       // Only the row of the measured source is returned (and validated)
+                                       auto table = dijkstra_batch(graph, sources);
+                                       std::vector<float> distances(table.begin(), table.begin() + number_of_vertexes);
+                                       if (parents != nullptr)
+                                       {
+                                           dijkstra_parents_from_distances(graph, source_vertex, distances, *parents);
+                                       }
+                                       return distances;
+                                   }});
+    }
+
+    struct OpenCLDevice
+    {
+        bool found;
+        cl_context context;
+        const char *name;
+        const char *description;
+    };
+    const OpenCLDevice devices[] = {
+        { config.cpu_found, config.cpu_context, "opencl-cpu", "OpenCL CPU device" },
+        { config.gpu_found, config.gpu_context, "opencl-gpu", "OpenCL GPU device" },
+    };
+
+    for (const auto &device : devices)
+    {
+        if (!device.found)
+        {
+            continue;
+        }
+
+        // Building (or loading) the program is a one-off cost, keep it out of the timed runs
+        auto context = device.context;
+        auto build_program = [context](const Graph &) { opencl_engine(context); };
+
+        backends.push_back(Backend{device.name, std::string("Harish-Narayanan kernels, ") + device.description,
+                                   build_program,
+                                   [context](const Graph &graph, int source_vertex, std::vector<int> *parents) mutable
+                                   {
+                                       return dijkstra_opencl(graph, source_vertex, context, parents);
+                                   }});
+        backends.push_back(Backend{std::string(device.name) + "-frontier",
+                                   std::string("Frontier-compacted kernels, ") + device.description, build_program,
+                                   [context](const Graph &graph, int source_vertex, std::vector<int> *parents) mutable
+                                   {
+                                       return dijkstra_opencl_frontier(graph, source_vertex, context, parents);
+                                   }});
+    }
+
+#if ENABLE_CUDA == 1
+    backends.push_back(Backend{"cuda", "Harish-Narayanan kernels, CUDA", nullptr, dijkstra_cuda});
+#endif
+
+    backends.push_back(Backend{"acc", "Harish-Narayanan algorithm, OpenACC", nullptr, dijkstra_acc});
+
+    return backends;
+}
+
+std::vector<PointToPointEngine> available_point_to_point_engines(const BackendConfig &config,
+                                                                 const std::vector<Backend> &backends)
+{
+    std::vector<PointToPointEngine> engines;
+
+    // Plain Dijkstra that stops at the target, the baseline of the speedups
+    auto dijkstra = std::make_shared<GraphCopy<AStarSearch>>([](const Graph &graph)
+    {
+        return new AStarSearch(graph, nullptr);
+    });
+    engines.push_back(PointToPointEngine{"dijkstra", "Heap Dijkstra from the source, stops when the target is settled",
+                                         [dijkstra](const Graph &graph) { dijkstra->For(graph); },
+                                         [dijkstra](const Graph &graph, int source_vertex, int target_vertex)
+                                         {
+                                             return dijkstra->For(graph).Query(source_vertex, target_vertex);
+                                         }});
+
+    // A whole single-source run for every pair
+    engines.push_back(PointToPointEngine{"sssp", "Full heap Dijkstra from the source, path from the parent tree",
+                                         nullptr,
+                                         [](const Graph &graph, int source_vertex, int target_vertex)
+                                         {
+                                             std::vector<int> parents;
+                                             auto distances = dijkstra_sequential_heap(graph, source_vertex, &parents);
+
+                                             PointToPointResult result;
+                                             result.distance = distances[target_vertex];
+                                             result.path = dijkstra_path(parents, source_vertex, target_vertex);
+                                             result.settled = std::count_if(distances.begin(), distances.end(),
+                                                                            [](float d) { return d != FLT_MAX; });
+                                             return result;
+                                         }});
+
+    // Graph::Reverse() is built with the search, outside of the timed queries
+    auto bidirectional = std::make_shared<GraphCopy<BidirectionalDijkstra>>();
+    engines.push_back(PointToPointEngine{"bidirectional", "Bidirectional Dijkstra, stops when the searches meet",
+                                         [bidirectional](const Graph &graph) { bidirectional->For(graph); },
+                                         [bidirectional](const Graph &graph, int source_vertex, int target_vertex)
+                                         {
+                                             return bidirectional->For(graph).Query(source_vertex, target_vertex);
+                                         }});
+
+    // The landmark tables are computed by one of the SSSP backends, a
+    // parallel one by default
+    auto table_backend = std::find_if(backends.begin(), backends.end(), [&config](const Backend &backend)
+    {
+        return backend.name == config.alt_backend;
+    });
+    if (table_backend != backends.end())
+    {
+        struct Alt
+        {
+            AltIndex index;
+            AStarSearch search;
+
+            Alt(const Graph &graph, int landmarks, AltIndex::SsspEngine sssp) :
+                index(graph, landmarks, sssp), search(graph, &this->index)
+            {
+            }
+        };
+
+        auto backend = *table_backend;
+        auto landmarks = config.alt_landmarks;
+        auto alt = std::make_shared<GraphCopy<Alt>>([backend, landmarks](const Graph &graph)
+        {
+            return new Alt(graph, landmarks, [backend](const Graph &graph, int source_vertex)
+            {
+                if (backend.prepare)
+                {
+                    backend.prepare(graph);
+                }
+                return backend.run(graph, source_vertex, nullptr);
+            });
+        });
+
+        std::ostringstream description;
+        description << "A* with " << landmarks << " landmark lower bounds (tables by " << backend.name << ")";
+        engines.push_back(PointToPointEngine{"alt", description.str(),
+                                             [alt](const Graph &graph) { alt->For(graph); },
+                                             [alt](const Graph &graph, int source_vertex, int target_vertex)
+                                             {
+                                                 return alt->For(graph).search.Query(source_vertex, target_vertex);
+                                             },
+                                             [alt, backend]()
+                                             {
+                                                 const auto &index = alt->Last().index;
+                                                 std::ostringstream report;
+                                                 report << std::fixed << std::setprecision(2)
+                                                        << index.Landmarks().size() << " landmarks, tables "
+                                                        << index.Bytes() / 1048576. << " MiB, preprocessing "
+                                                        << std::setprecision(6) << index.PreprocessingSeconds()
+                                                        << " s with " << backend.name;
+                                                 return report.str();
+                                             }});
+    }
+
+    // The vertices are ranked on the graph as given, with a progress line
+    // per tenth of them.  Graphs without a hierarchy of their own (uniform
+    // random, Erdős–Rényi, R-MAT) leave most vertices in the core, whose
+    // denser arcs make the query slower than bidirectional Dijkstra on the
+    // graph itself.  After preprocessing both are timed on the same random
+    // pairs, and unless the hierarchy is clearly faster the queries go to
+    // bidirectional Dijkstra
+    struct Ch
+    {
+        ContractionHierarchy hierarchy;
+        ContractionHierarchySearch search;
+        BidirectionalDijkstra bidirectional;
+        double sample_speedup;      // of the hierarchy over bidirectional on the sample
+        bool routed;                // queries answered by bidirectional
+
+        explicit Ch(const Graph &graph) :
+            hierarchy(graph, print_progress), search(this->hierarchy), bidirectional(graph), sample_speedup(1.),
+            routed(false)
+        {
+            auto number_of_vertexes = static_cast<uint32_t>(graph.vertex_array.size());
+            if (number_of_vertexes == 0)
+            {
+                return;
+            }
+
+            std::vector<std::pair<int, int>> pairs;
+            CounterRng rng(0, 0x4348);
+            for (auto i = 0; i < CH_ROUTING_PAIRS; ++i)
+            {
+                auto source_vertex = static_cast<int>(rng.NextBounded(number_of_vertexes));
+                pairs.push_back(std::make_pair(source_vertex, static_cast<int>(rng.NextBounded(number_of_vertexes))));
+            }
+
+            // Alternated twice, the faster pass of each counts
+            auto hierarchy_seconds = DBL_MAX, bidirectional_seconds = DBL_MAX;
+            for (auto pass = 0; pass < 2; ++pass)
+            {
+                auto start = std::chrono::high_resolution_clock::now();
+                for (const auto &pair : pairs)
+                {
+                    this->search.Query(pair.first, pair.second);
+                }
+                hierarchy_seconds = std::min(hierarchy_seconds, seconds_since(start));
+
+                start = std::chrono::high_resolution_clock::now();
+                for (const auto &pair : pairs)
+                {
+                    this->bidirectional.Query(pair.first, pair.second);
+                }
+                bidirectional_seconds = std::min(bidirectional_seconds, seconds_since(start));
+            }
+            this->sample_speedup = bidirectional_seconds / std::max(hierarchy_seconds, 1e-9);
+            this->routed = this->sample_speedup < CH_ROUTING_MIN_SPEEDUP;
+        }
+
+        PointToPointResult Query(int source_vertex, int target_vertex)
+        {
+            return this->routed ? this->bidirectional.Query(source_vertex, target_vertex)
+                                : this->search.Query(source_vertex, target_vertex);
+        }
+
+        static void print_progress(int contracted, int total, long long shortcuts)
+        {
+            static int printed = 0;
+            auto step = std::max(1, total / 10);
+            if (contracted == total || contracted / step > printed)
+            {
+                printed = contracted == total ? 0 : contracted / step;
+                std::cout << "  ch: contracted " << contracted << " / " << total << ", " << shortcuts
+                          << " shortcuts" << std::endl;
+            }
+        }
+    };
+
+    auto ch = std::make_shared<GraphCopy<Ch>>();
+    engines.push_back(PointToPointEngine{"ch", "Contraction hierarchy, bidirectional upward search "
+                                         "(bidirectional Dijkstra where that is faster)",
+                                         [ch](const Graph &graph) { ch->For(graph); },
+                                         [ch](const Graph &graph, int source_vertex, int target_vertex)
+                                         {
+                                             return ch->For(graph).Query(source_vertex, target_vertex);
+                                         },
+                                         [ch]()
+                                         {
+                                             const auto &engine = ch->Last();
+                                             const auto &hierarchy = engine.hierarchy;
+                                             std::ostringstream report;
+                                             report << std::fixed << std::setprecision(2) << hierarchy.Shortcuts()
+                                                    << " shortcuts in " << hierarchy.Rounds() << " rounds, core "
+                                                    << hierarchy.CoreVertexes() << " vertices, "
+                                                    << hierarchy.Bytes() / 1048576. << " MiB, preprocessing "
+                                                    << std::setprecision(6) << hierarchy.PreprocessingSeconds()
+                                                    << " s, " << std::setprecision(2) << engine.sample_speedup
+                                                    << "x of bidirectional on " << CH_ROUTING_PAIRS << " pairs"
+                                                    << (engine.routed ? ", queries routed to bidirectional" : "");
+                                             return report.str();
+                                         }});
+
+    // The O(V^2) reference as a point-to-point engine, only on request
+    auto sequential = std::find_if(backends.begin(), backends.end(), [](const Backend &backend)
+    {
+        return backend.name == "sequential";
+    });
+    if (sequential != backends.end())
+    {
+        auto backend = *sequential;
+        engines.push_back(PointToPointEngine{"sequential", "Reference O(V^2) Dijkstra from the source (on request)",
+                                             backend.prepare,
+                                             [backend](const Graph &graph, int source_vertex, int target_vertex)
+                                             {
+                                                 std::vector<int> parents;
+                                                 auto distances = backend.run(graph, source_vertex, &parents);
+
+                                                 PointToPointResult result;
+                                                 result.distance = distances[target_vertex];
+                                                 result.path = dijkstra_path(parents, source_vertex, target_vertex);
+                                                 result.settled = std::count_if(distances.begin(), distances.end(),
+                                                                                [](float d) { return d != FLT_MAX; });
+                                                 return result;
+                                             },
+                                             nullptr, false});
+    }
+
+    return engines;
+}
+
+static bool file_exists(const std::string &path)
+{
+    std::ifstream file(path);
+    return file.good();
+}
+
+static Graph load_input(const BenchmarkOptions &options)
+{
+    if (options.input_format == "dimacs")
+    {
+        return Graph::FromDimacs(options.input_path);
+    }
+    if (options.input_format == "snapshot")
+    {
+        return Graph::FromSnapshot(options.input_path);
+    }
+    return Graph::FromSnap(options.input_path);
+}
+
+static Graph generate_graph(const BenchmarkOptions &options, int vertices, int degree, uint64_t seed)
+{
+    if (options.snapshot_dir.empty())
+    {
+        return Graph(vertices, degree, GRAPH_STORAGE_SPARSE, options.topology, seed);
+    }
+
+    std::ostringstream path;
+    path << options.snapshot_dir << "/" << topology_name(options.topology) << "_" << vertices << "_" << degree
+         << "_" << seed << ".csr";
+
+    if (file_exists(path.str()))
+    {
+        return Graph::FromSnapshot(path.str());
+    }
+
+    Graph graph(vertices, degree, GRAPH_STORAGE_SPARSE, options.topology, seed);
+    graph.SaveSnapshot(path.str());
+    return graph;
+}
+
+Graph load_graph(const BenchmarkOptions &options)
+{
+    if (!options.input_path.empty())
+    {
+        return load_input(options);
+    }
+
+    auto vertices = options.sizes.front();
+    auto degree = options.degrees.empty() ? vertices / options.degree_divisor : options.degrees.front();
+    return generate_graph(options, vertices, degree, options.seeds.front());
+}
+
+static void write_csv_header(std::ofstream &csv)
+{
+    csv << "graph,vertices,edges,degree,seed,backend,prepare_seconds,runs,min,median,p95,mean,stddev,mismatches" << std::endl;
+}
+
+static void write_csv_row(std::ofstream &csv, const BenchmarkResult &result)
+{
+    csv << std::setprecision(9) << result.graph << "," << result.vertices << "," << result.edges << ","
+        << result.degree << "," << result.seed << "," << result.backend << "," << result.prepare_seconds << ","
+        << result.stats.samples << "," << result.stats.min << "," << result.stats.median << ","
+        << result.stats.p95 << "," << result.stats.mean << "," << result.stats.stddev << "," << result.mismatches << std::endl;
+}
+
+static void write_json(const std::string &path, const std::vector<BenchmarkResult> &results)
+{
+    std::ofstream json(path);
+    if (!json.good())
+    {
+        std::cerr << "Failed to open file for writing: " << path << std::endl;
+        return;
+    }
+
+    json << std::setprecision(9) << "{\n  \"results\": [";
+    for (auto i = 0ULL; i < results.size(); ++i)
+    {
+        const auto &result = results[i];
+        json << (i ? "," : "") << "\n    {\"graph\": \"" << json_escape(result.graph) << "\", \"vertices\": "
+             << result.vertices << ", \"edges\": " << result.edges << ", \"degree\": " << result.degree
+             << ", \"seed\": " << result.seed << ", \"backend\": \"" << result.backend
+             << "\", \"prepare_seconds\": " << result.prepare_seconds << ", \"samples\": [";
+        for (auto j = 0ULL; j < result.samples.size(); ++j)
+        {
+            json << (j ? ", " : "") << result.samples[j];
+        }
+        json << "], \"min\": " << result.stats.min << ", \"median\": " << result.stats.median
+             << ", \"p95\": " << result.stats.p95 << ", \"mean\": " << result.stats.mean
+             << ", \"stddev\": " << result.stats.stddev << ", \"mismatches\": " << result.mismatches << "}";
+    }
+    json << "\n  ]\n}" << std::endl;
+}
+
+static bool distances_match(float expected, float actual, float tolerance)
+{
+    if (expected == FLT_MAX || actual == FLT_MAX)
+    {
+        return expected == actual;
+    }
+    return std::fabs(expected - actual) <= tolerance * std::max(1.f, std::fabs(expected));
+}
+
+///
+/// Compare `actual` against the reference distances, print the first
+/// mismatching vertices and return the number of mismatches
+///
+static long long validate_distances(const std::string &backend, const std::vector<float> &expected,
+                                    const std::vector<float> &actual, float tolerance)
+{
+    if (expected.size() != actual.size())
+    {
+        std::cerr << "  " << backend << ": returned " << actual.size() << " distances, expected "
+                  << expected.size() << std::endl;
+        return static_cast<long long>(std::max(expected.size(), actual.size()));
+    }
+
+    long long mismatches = 0;
+    for (auto v = 0ULL; v < expected.size(); ++v)
+    {
+        if (distances_match(expected[v], actual[v], tolerance))
+        {
+            continue;
+        }
+        if (mismatches < VALIDATION_REPORT_LIMIT)
+        {
+            std::cerr << std::setprecision(9) << "  " << backend << ": vertex " << v << " distance " << actual[v]
+                      << ", reference " << expected[v] << std::endl;
+        }
+        ++mismatches;
+    }
+
+    if (mismatches > 0)
+    {
+        std::cerr << "  " << backend << ": " << mismatches << " of " << expected.size()
+                  << " distances differ from the reference" << std::endl;
+    }
+    return mismatches;
+}
+
+///
+/// Check that `parents` is a shortest path tree for `distances`: every reached
+/// vertex hangs off a closer vertex through an edge that is tight within the
+/// tolerance.  Returns the number of vertices with a wrong parent.
+///
+static long long validate_parents(const std::string &backend, const Graph &graph, int source_vertex,
+                                  const std::vector<float> &distances, const std::vector<int> &parents, float tolerance)
+{
+    if (parents.size() != distances.size())
+    {
+        std::cerr << "  " << backend << ": returned " << parents.size() << " parents, expected "
+                  << distances.size() << std::endl;
+        return static_cast<long long>(std::max(parents.size(), distances.size()));
+    }
+
+    long long mismatches = 0;
+    for (auto v = 0ULL; v < parents.size(); ++v)
+    {
+        auto parent = parents[v];
+        bool valid;
+
+        if (static_cast<int>(v) == source_vertex)
+        {
+            valid = parent == source_vertex;
+        }
+        else if (distances[v] == FLT_MAX)
+        {
+            valid = parent == DIJKSTRA_NO_PARENT;
+        }
+        else
+        {
+            valid = false;
+            if (parent >= 0 && static_cast<size_t>(parent) < parents.size() && distances[parent] < distances[v])
+            {
+                auto edge_end = graph.EdgesEnd(parent);
+                for (auto edge = graph.EdgesBegin(parent); edge < edge_end && !valid; ++edge)
+                {
+                    valid = graph.edge_array[edge] == static_cast<int>(v) &&
+                            distances_match(distances[v], distances[parent] + graph.weight_array[edge], tolerance);
+                }
+            }
+        }
+
+        if (valid)
+        {
+            continue;
+        }
+        if (mismatches < VALIDATION_REPORT_LIMIT)
+        {
+            std::cerr << "  " << backend << ": vertex " << v << " has parent " << parent
+                      << ", which is not on a shortest path" << std::endl;
+        }
+        ++mismatches;
+    }
+
+    if (mismatches > 0)
+    {
+        std::cerr << "  " << backend << ": " << mismatches << " of " << parents.size()
+                  << " parents are wrong" << std::endl;
+    }
+    return mismatches;
+}
+
+///
+/// Prepare `backend` for `graph` and time warmup + repetitions runs from the
+/// source vertex into `result`; the last run is printed and validated.  For a
+/// reordered graph the source is mapped in and the results are mapped back to
+/// the original ids inside the timed region, so the numbers include the cost
+/// of the renumbering being transparent.
+///
+static void measure_backend(const BenchmarkOptions &options, const Backend &backend, const Graph &graph,
+                            const Graph &original, const std::vector<float> *expected, bool want_parents,
+                            BenchmarkResult &result)
+{
+    std::vector<int> parents;
+    auto source_vertex = graph.InternalId(options.source_vertex);
+
+    result.samples.clear();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    if (backend.prepare)
+    {
+        backend.prepare(graph);
+    }
+    result.prepare_seconds = seconds_since(start);
+
+    for (int run = 0; run < options.warmup + options.repetitions; ++run)
+    {
+        start = std::chrono::high_resolution_clock::now();
+        auto distances = backend.run(graph, source_vertex, want_parents ? &parents : nullptr);
+        if (graph.IsReordered())
+        {
+            distances = graph.ToOriginalOrder(distances);
+            if (want_parents)
+            {
+                parents = graph.ParentsToOriginalOrder(parents);
+            }
+        }
+        auto elapsed = seconds_since(start);
+
+        if (run >= options.warmup)
+        {
+            result.samples.push_back(elapsed);
+        }
+        if (run == options.warmup + options.repetitions - 1)
+        {
+            print_results(backend.description, distances, options.source_vertex);
+            if (want_parents)
+            {
+                print_paths(backend.description, parents, options.source_vertex);
+            }
+            if (expected != nullptr)
+            {
+                result.mismatches = validate_distances(result.backend, *expected, distances, options.tolerance);
+                if (want_parents)
+                {
+                    result.mismatches += validate_parents(result.backend, original, options.source_vertex,
+                                                          distances, parents, options.tolerance);
+                }
+            }
+        }
+    }
+
+    result.stats = compute_stats(result.samples);
+    std::cout << std::fixed << std::setprecision(6) << "  " << std::left << std::setw(16) << result.backend
+              << std::right << " min " << result.stats.min << " s, median " << result.stats.median
+              << " s, p95 " << result.stats.p95 << " s, stddev " << result.stats.stddev << " s ("
+              << result.stats.samples << " runs)" << (result.mismatches > 0 ? " DIVERGED" : "") << std::endl;
+    if (backend.report)
+    {
+        std::cout << "  " << std::string(16, ' ') << " " << backend.report() << std::endl;
+    }
+}
+
+///
+/// Check a point-to-point answer against the reference distance: same
+/// distance, and a path from the source to the target along edges of the
+/// graph whose weights add up to it.  Returns 1 for a wrong answer.
+///
+static long long validate_point_to_point(const std::string &engine, const Graph &graph, int source_vertex,
+                                         int target_vertex, float expected, const PointToPointResult &result,
+                                         float tolerance)
+{
+    std::ostringstream error;
+    if (!distances_match(expected, result.distance, tolerance))
+    {
+        error << "distance " << result.distance << ", reference " << expected;
+    }
+    else if (expected != FLT_MAX)
+    {
+        auto length = 0.f;
+        auto valid = !result.path.empty() && result.path.front() == source_vertex && result.path.back() == target_vertex;
+        for (auto i = 0ULL; valid && i + 1 < result.path.size(); ++i)
+        {
+            // The lightest of parallel edges is the one a shortest path takes
+            auto weight = FLT_MAX;
+            auto edge_end = graph.EdgesEnd(result.path[i]);
+            for (auto edge = graph.EdgesBegin(result.path[i]); edge < edge_end; ++edge)
+            {
+                if (graph.edge_array[edge] == result.path[i + 1])
+                {
+                    weight = std::min(weight, graph.weight_array[edge]);
+                }
+            }
+            valid = weight != FLT_MAX;
+            length += weight;
+        }
+
+        if (!valid || !distances_match(expected, length, tolerance))
+        {
+            error << "path of " << result.path.size() << " vertices is not a shortest path";
+        }
+    }
+
+    if (error.str().empty())
+    {
+        return 0;
+    }
+    std::cerr << std::setprecision(9) << "  " << engine << ": " << source_vertex << " -> " << target_vertex << ": "
+              << error.str() << std::endl;
+    return 1;
+}
+
+///
+/// Time every point-to-point engine over the same `options.p2p_queries`
+/// random pairs and print the latencies, the share of the graph each query
+/// settled and the speedup over plain Dijkstra
+///
+static void benchmark_point_to_point(const BenchmarkOptions &options,
+                                     const std::vector<const PointToPointEngine *> &engines,
+                                     const Backend *reference, const Graph &graph, BenchmarkResult result,
+                                     std::vector<BenchmarkResult> &results, std::ofstream &csv)
+{
+    auto number_of_vertexes = static_cast<uint32_t>(graph.vertex_array.size());
+
+    std::vector<std::pair<int, int>> pairs;
+    CounterRng rng(result.seed, 0x5032);
+    for (int i = 0; i < options.p2p_queries; ++i)
+    {
+        auto source_vertex = static_cast<int>(rng.NextBounded(number_of_vertexes));
+        pairs.push_back(std::make_pair(source_vertex, static_cast<int>(rng.NextBounded(number_of_vertexes))));
+    }
+
+    std::vector<float> expected;
+    if (reference != nullptr)
+    {
+        for (const auto &pair : pairs)
+        {
+            expected.push_back(reference->run(graph, pair.first, nullptr)[pair.second]);
+        }
+    }
+
+    // Speedups are over plain Dijkstra with early termination (the first
+    // engine registered) if it runs, over the first engine otherwise
+    auto baseline_engine = std::find_if(engines.begin(), engines.end(), [](const PointToPointEngine *engine)
+    {
+        return engine->name == "dijkstra";
+    });
+    auto baseline_name = engines.empty() ? std::string() : (baseline_engine != engines.end() ? *baseline_engine
+                                                                                             : engines.front())->name;
+    auto baseline = 0.;
+
+    std::cout << "Point-to-point, " << pairs.size() << " random pairs (speedup over " << baseline_name << "):"
+              << std::endl;
+    for (auto engine : engines)
+    {
+        result.backend = "p2p-" + engine->name;
+        result.samples.clear();
+        result.mismatches = reference != nullptr ? 0 : -1;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        if (engine->prepare)
+        {
+            engine->prepare(graph);
+        }
+        result.prepare_seconds = seconds_since(start);
+
+        long long settled = 0;
+        for (auto i = 0ULL; i < pairs.size(); ++i)
+        {
+            start = std::chrono::high_resolution_clock::now();
+            auto answer = engine->query(graph, pairs[i].first, pairs[i].second);
+            result.samples.push_back(seconds_since(start));
+
+            settled += answer.settled;
+            if (reference != nullptr)
+            {
+                result.mismatches += validate_point_to_point(engine->name, graph, pairs[i].first, pairs[i].second,
+                                                             expected[i], answer, options.tolerance);
+            }
+        }
+
+        result.stats = compute_stats(result.samples);
+        if (engine->name == baseline_name)
+        {
+            baseline = result.stats.median;
+        }
+        std::cout << std::fixed << std::setprecision(6) << "  " << std::left << std::setw(16) << engine->name
+                  << std::right << " median " << result.stats.median << " s, p95 " << result.stats.p95
+                  << " s, prepare " << result.prepare_seconds << " s" << std::setprecision(2) << ", settled "
+                  << 100. * settled / std::max<double>(1., static_cast<double>(pairs.size()) * number_of_vertexes)
+                  << "% of V, speedup " << baseline / result.stats.median << "x"
+                  << (result.mismatches > 0 ? " DIVERGED" : "") << std::endl;
+        if (engine->report)
+        {
+            std::cout << "  " << std::string(16, ' ') << " " << engine->report() << std::endl;
+        }
+
+        if (csv.good())
+        {
+            write_csv_row(csv, result);
+        }
+        results.push_back(result);
+    }
+}
+
+///
+/// For every batch size of `options.dynamic_batches`, apply `options.repetitions`
+/// batches of random edge-weight changes to the graph and time
+/// DynamicSssp::Repair against a full dijkstra_sequential_heap run with
+/// parents on the changed graph.  The weights are restored afterwards.
+///
+static void benchmark_dynamic(const BenchmarkOptions &options, Graph &graph, BenchmarkResult result,
+                              std::vector<BenchmarkResult> &results, std::ofstream &csv)
+{
+    auto number_of_vertexes = static_cast<double>(graph.vertex_array.size());
+    auto number_of_edges = static_cast<uint32_t>(graph.edge_array.size());
+    if (number_of_edges == 0)
+    {
+        return;
+    }
+
+    std::vector<EdgeWeightUpdate> original;
+    std::cout << "Dynamic SSSP from vertex " << options.source_vertex << ", " << options.repetitions
+              << " batches per size:" << std::endl;
+
+    // The repair reads the in-edges from Graph::Reverse(), built here rather than in the first timed batch
+    graph.Reverse();
+    DynamicSssp dynamic(graph, options.source_vertex);
+    CounterRng rng(result.seed, 0x4459);
+    for (auto batch_size : options.dynamic_batches)
+    {
+        BenchmarkResult repair = result, full = result;
+        repair.backend = "dynamic-repair-" + std::to_string(batch_size);
+        full.backend = "dynamic-full-" + std::to_string(batch_size);
+        repair.prepare_seconds = full.prepare_seconds = 0.;
+        repair.mismatches = options.validate ? 0 : -1;
+        full.mismatches = -1;
+
+        long long invalidated = 0, settled = 0;
+        for (auto batch = 0; batch < options.repetitions; ++batch)
+        {
+            // New weights drawn like the generated ones, about half of them heavier
+            std::vector<EdgeWeightUpdate> updates;
+            for (auto i = 0; i < batch_size; ++i)
+            {
+                auto edge = static_cast<int>(rng.NextBounded(number_of_edges));
+                original.push_back(EdgeWeightUpdate{edge, graph.weight_array[edge]});
+                updates.push_back(EdgeWeightUpdate{edge, (1 + rng.NextBounded(1000)) / 1000.f});
+            }
+
+            auto start = std::chrono::high_resolution_clock::now();
+            graph.UpdateWeights(updates);
+            auto stats = dynamic.Repair(updates);
+            repair.samples.push_back(seconds_since(start));
+            invalidated += stats.invalidated;
+            settled += stats.settled;
+
+            std::vector<int> parents;
+            start = std::chrono::high_resolution_clock::now();
+            auto expected = dijkstra_sequential_heap(graph, options.source_vertex, &parents);
+            full.samples.push_back(seconds_since(start));
+
+            if (options.validate)
+            {
+                repair.mismatches += validate_distances(repair.backend, expected, dynamic.Distances(),
+                                                        options.tolerance);
+                repair.mismatches += validate_parents(repair.backend, graph, options.source_vertex,
+                                                      dynamic.Distances(), dynamic.Parents(), options.tolerance);
+            }
+        }
+
+        repair.stats = compute_stats(repair.samples);
+        full.stats = compute_stats(full.samples);
+        std::cout << std::fixed << std::setprecision(6) << "  " << std::left << std::setw(8) << batch_size
+                  << std::right << " edges: repair median " << repair.stats.median << " s, full median "
+                  << full.stats.median << " s" << std::setprecision(2) << ", speedup "
+                  << full.stats.median / repair.stats.median << "x, invalidated "
+                  << 100. * invalidated / (options.repetitions * number_of_vertexes) << "% of V, settled "
+                  << 100. * settled / (options.repetitions * number_of_vertexes) << "% of V"
+                  << (repair.mismatches > 0 ? " DIVERGED" : "") << std::endl;
+
+        for (const auto &row : { repair, full })
+        {
+            if (csv.good())
+            {
+                write_csv_row(csv, row);
+            }
+            results.push_back(row);
+        }
+    }
+
+    // Later changes of an edge first, so that the first original weight wins
+    std::reverse(original.begin(), original.end());
+    graph.UpdateWeights(original);
+}
+
+static void benchmark_graph(const BenchmarkOptions &options, const std::vector<const Backend *> &selected,
+                            const std::vector<const PointToPointEngine *> &p2p_selected,
+                            const Backend *reference, Graph &graph, BenchmarkResult result,
+                            std::vector<BenchmarkResult> &results, std::ofstream &csv)
+{
+
+    result.vertices = graph.vertex_array.size();
+    result.edges = graph.edge_array.size();
+    result.mismatches = -1;
+
+    // Paths are printed from the parent array, so ENABLE_PATH_PRINT implies --parents
+#if ENABLE_PATH_PRINT != 0
+    bool want_parents = true;
+#else
+    bool want_parents = options.parents;
+#endif
+
+    std::vector<float> expected;
+    if (reference != nullptr)
+    {
+        if (reference->prepare)
+        {
+            reference->prepare(graph);
+        }
+        expected = reference->run(graph, options.source_vertex, nullptr);
+    }
+
+    if (options.p2p_queries > 0)
+    {
+        benchmark_point_to_point(options, p2p_selected, reference, graph, result, results, csv);
+    }
+
+    if (!options.dynamic_batches.empty())
+    {
+        benchmark_dynamic(options, graph, result, results, csv);
+    }
+
+    // The renumbered copy is built once per graph, its cost is paid back by
+    // the queries it speeds up
+    std::unique_ptr<Graph> reordered;
+    double reorder_seconds = 0;
+    if (options.reorder)
+    {
+        std::cout << "Reordering (" << ordering_name(options.ordering) << ")...";
+        std::cout.flush();
+        auto start = std::chrono::high_resolution_clock::now();
+        reordered.reset(new Graph(graph.Reordered(options.ordering)));
+        reorder_seconds = seconds_since(start);
+        std::cout << "\tDone (" << reorder_seconds << " s)" << std::endl;
+    }
+
+    for (auto backend : selected)
+    {
+        result.backend = backend->name;
+        measure_backend(options, *backend, graph, graph, reference != nullptr ? &expected : nullptr,
+                        want_parents, result);
+        if (csv.good())
+        {
+            write_csv_row(csv, result);
+        }
+        results.push_back(result);
+
+        if (reordered == nullptr)
+        {
+            continue;
+        }
+
+        auto baseline = result.stats.median;
+        result.backend = backend->name + "+" + ordering_name(options.ordering);
+        measure_backend(options, *backend, *reordered, graph, reference != nullptr ? &expected : nullptr,
+                        want_parents, result);
+
+        auto saved = baseline - result.stats.median;
+        std::cout << std::fixed << std::setprecision(2) << "  " << std::string(16, ' ') << " speedup "
+                  << baseline / result.stats.median << "x, ";
+        if (saved > 0)
+        {
+            std::cout << "the reorder pays for itself after " << static_cast<long long>(std::ceil(reorder_seconds / saved))
+                      << " queries" << std::endl;
+        }
+        else
+        {
+            std::cout << "the reorder does not pay for itself" << std::endl;
+        }
+
+        if (csv.good())
+        {
+            write_csv_row(csv, result);
+        }
+        results.push_back(result);
+    }
+}
+
+int run_benchmark(const BenchmarkOptions &options, const std::vector<Backend> &backends,
+                  const std::vector<PointToPointEngine> &p2p_engines)
+{
+    // Point-to-point and dynamic runs replace the SSSP backends unless those are asked for too
+    std::vector<const Backend *> selected;
+    if (options.backends.empty() && options.p2p_queries == 0 && options.dynamic_batches.empty())
+    {
+        for (const auto &backend : backends)
+        {
+            selected.push_back(&backend);
+        }
+    }
+    for (const auto &name : options.backends)
+    {
+        auto found = std::find_if(backends.begin(), backends.end(), [&name](const Backend &backend)
+        {
+            return backend.name == name;
+        });
+        if (found == backends.end())
+        {
+            std::cerr << "Unknown or unavailable backend: " << name << std::endl;
+            return 1;
+        }
+        selected.push_back(&*found);
+    }
+
+    std::vector<const PointToPointEngine *> p2p_selected;
+    for (const auto &engine : p2p_engines)
+    {
+        if ((options.p2p_engines.empty() && engine.by_default) ||
+            std::find(options.p2p_engines.begin(), options.p2p_engines.end(), engine.name) != options.p2p_engines.end())
+        {
+            p2p_selected.push_back(&engine);
+        }
+    }
+    for (const auto &name : options.p2p_engines)
+    {
+        auto found = std::find_if(p2p_engines.begin(), p2p_engines.end(), [&name](const PointToPointEngine &engine)
+        {
+            return engine.name == name;
+        });
+        if (found == p2p_engines.end())
+        {
+            std::cerr << "Unknown point-to-point engine: " << name << std::endl;
+            return 1;
+        }
+    }
+
+    const Backend *reference = nullptr;
+    if (options.validate)
+    {
+        auto found = std::find_if(backends.begin(), backends.end(), [&options](const Backend &backend)
+        {
+            return backend.name == options.reference;
+        });
+        if (found == backends.end())
+        {
+            std::cerr << "Unknown or unavailable reference backend: " << options.reference << std::endl;
+            return 1;
+        }
+        reference = &*found;
+    }
+
+    std::ofstream csv;
+    if (!options.csv_path.empty())
+    {
+        csv.open(options.csv_path);
+        write_csv_header(csv);
+    }
+
+    std::vector<BenchmarkResult> results;
+    BenchmarkResult result;
+    result.seed = 0;
+
+    if (!options.input_path.empty())
+    {
+        std::cout << "Loading graph from " << options.input_path << "...";
+        std::cout.flush();
+        auto start = std::chrono::high_resolution_clock::now();
+        Graph graph = load_input(options);
+        std::cout << "\tDone (" << seconds_since(start) << " s)" << std::endl;
+
+        if (static_cast<size_t>(options.source_vertex) >= graph.vertex_array.size())
+        {
+            std::cerr << "Source vertex " << options.source_vertex << " is not in the graph" << std::endl;
+            return 1;
+        }
+
+        result.graph = options.input_path;
+        result.degree = graph.NeighborsPerVertex();
+        benchmark_graph(options, selected, p2p_selected, reference, graph, result, results, csv);
+    }
+    else
+    {
+        result.graph = topology_name(options.topology);
+        for (auto vertices : options.sizes)
+        {
+            std::vector<int> degrees = options.degrees;
+            if (degrees.empty())
+            {
+                degrees.push_back(vertices / options.degree_divisor);
+            }
+
+            for (auto degree : degrees)
+            {
+                for (auto seed : options.seeds)
+                {
+                    std::cout << "Generating " << result.graph << " graph with " << vertices << " vertices and "
+                              << degree << " neighbors per vertex (seed " << seed << ")...";
+                    std::cout.flush();
+                    auto start = std::chrono::high_resolution_clock::now();
+                    Graph graph = generate_graph(options, vertices, degree, seed);
+                    std::cout << "\tDone (" << seconds_since(start) << " s)" << std::endl;
+
+                    if (static_cast<size_t>(options.source_vertex) >= graph.vertex_array.size())
+                    {
+                        std::cerr << "Source vertex " << options.source_vertex << " is not in the graph" << std::endl;
+                        return 1;
+                    }
+
+                #if PRINT_GRAPH_DATA != 0
+                    graph.PrintVertexData();
+                    graph.DisplayWeightMatrix();
+                #endif
+
+                    result.degree = degree;
+                    result.seed = seed;
+                    benchmark_graph(options, selected, p2p_selected, reference, graph, result, results, csv);
+                }
+            }
+        }
+    }
+
+    if (!options.json_path.empty())
+    {
+        write_json(options.json_path, results);
+    }
+
+    auto diverged = std::count_if(results.begin(), results.end(), [](const BenchmarkResult &result)
+    {
+        return result.mismatches > 0;
+    });
+    if (diverged > 0)
+    {
+        std::cerr << "Validation failed: " << diverged << " backend runs diverged from " << options.reference << std::endl;
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "src/dijkstra.hpp"
+#include "src/point_to_point.hpp"
+
+///
+/// A backend the harness can run.  `prepare` (optional) builds whatever
+/// per-graph state the backend needs outside of the timed region, `run`
+/// computes the distances from one source vertex and, if asked, the parents.
+/// `report` (optional) describes backend-specific counters of the last run,
+/// it is printed after the timings.  `batch` (optional) computes the
+/// distances from several sources at once, the rows one after another
+/// (V floats per source); the query server runs the misses of a batch
+/// through it.
+///
+struct Backend
+{
+    std::string name;
+    std::string description;
+    std::function<void(const Graph &)> prepare;
+    std::function<std::vector<float>(const Graph &, int, std::vector<int> *)> run;
+    std::function<std::string()> report;
+    std::function<std::vector<float>(const Graph &, const std::vector<int> &)> batch;
+
+    Backend(const std::string &name, const std::string &description, std::function<void(const Graph &)> prepare,
+            std::function<std::vector<float>(const Graph &, int, std::vector<int> *)> run,
+            std::function<std::string()> report = nullptr) :
+        name(name), description(description), prepare(prepare), run(run), report(report)
+    {
+    }
+};
+
+///
+/// A point-to-point engine: `prepare` (optional) as for a Backend, `query`
+/// answers one source/target pair.  Timed per query over random pairs.
+/// Engines that are not `by_default` only run when --p2p-engines names them.
+///
+struct PointToPointEngine
+{
+    std::string name;
+    std::string description;
+    std::function<void(const Graph &)> prepare;
+    std::function<PointToPointResult(const Graph &, int, int)> query;
+    std::function<std::string()> report;
+    bool by_default;
+
+    PointToPointEngine(const std::string &name, const std::string &description,
+                       std::function<void(const Graph &)> prepare,
+                       std::function<PointToPointResult(const Graph &, int, int)> query,
+                       std::function<std::string()> report = nullptr, bool by_default = true) :
+        name(name), description(description), prepare(prepare), query(query), report(report),
+        by_default(by_default)
+    {
+    }
+};
+
+///
+/// Everything the backends need from the outside world
+///
+struct BackendConfig
+{
+    cl_context cpu_context;
+    cl_context gpu_context;
+    bool cpu_found;
+    bool gpu_found;
+    float delta;                // delta-stepping bucket width, 0 for the default
+    int batch_sources;          // sources per heap-batch run, 0 disables the backend
+    int alt_landmarks;          // landmarks of the ALT engine
+    std::string alt_backend;    // backend that computes the landmark tables
+};
+
+struct BenchmarkOptions
+{
+    std::vector<std::string> backends;      // empty -- every available backend
+    std::vector<int> sizes;
+    std::vector<int> degrees;               // empty -- size / degree_divisor (the original sweep)
+    int degree_divisor;
+    std::vector<uint64_t> seeds;
+    graph_topology_t topology;
+
+    std::string input_path;                 // run on this file instead of generated graphs
+    std::string input_format;               // dimacs, snap or snapshot
+    std::string snapshot_dir;               // cache generated graphs here as snapshots
+
+    int source_vertex;
+    int warmup;
+    int repetitions;
+    bool parents;                           // time the runs with the shortest path tree output
+
+    bool reorder;                           // also time every backend on a renumbered copy of the graph
+    graph_ordering_t ordering;
+
+    int p2p_queries;                        // random source/target pairs per graph, 0 -- no point-to-point runs
+    std::vector<std::string> p2p_engines;   // empty -- every default point-to-point engine
+
+    std::vector<int> dynamic_batches;       // edge-weight changes per batch of the dynamic runs, empty -- none
+
+    std::string csv_path;
+    std::string json_path;
+
+    bool validate;                          // compare every backend against `reference`
+    std::string reference;
+    float tolerance;                        // relative, |d - d_ref| <= tolerance * max(1, |d_ref|)
+};
+
+struct TimingStats
+{
+    int samples;
+    double min;
+    double median;
+    double p95;
+    double p99;
+    double mean;
+    double stddev;
+};
+
+const char *topology_name(graph_topology_t topology);
+bool parse_topology(const std::string &name, graph_topology_t &topology);
+
+const char *ordering_name(graph_ordering_t ordering);
+bool parse_ordering(const std::string &name, graph_ordering_t &ordering);
+
+TimingStats compute_stats(std::vector<double> samples);
+
+// The graph a server keeps resident: --input, or the first size, degree and
+// seed of the generated sweep
+Graph load_graph(const BenchmarkOptions &options);
+
+std::vector<Backend> available_backends(const BackendConfig &config);
+// `backends` are the SSSP engines preprocessing steps can use
+std::vector<PointToPointEngine> available_point_to_point_engines(const BackendConfig &config,
+                                                                 const std::vector<Backend> &backends);
+
+// Returns the process exit code, nonzero if a backend diverged from the reference
+int run_benchmark(const BenchmarkOptions &options, const std::vector<Backend> &backends,
+                  const std::vector<PointToPointEngine> &p2p_engines);
@@ -0,0 +1,125 @@
+#include "src/point_to_point.hpp"
+
+#include <algorithm>
+
+BidirectionalDijkstra::BidirectionalDijkstra(const Graph &graph) : graph(graph)
+{
+    auto number_of_vertexes = static_cast<int>(graph.vertex_array.size());
+
+    Side *sides[] = { &this->forward, &this->backward };
+    for (auto side : sides)
+    {
+        side->distances.assign(number_of_vertexes, FLT_MAX);
+        side->parents.assign(number_of_vertexes, DIJKSTRA_NO_PARENT);
+        side->queue.Resize(number_of_vertexes);
+    }
+    this->forward.graph = &graph;
+    this->backward.graph = &graph.Reverse();
+}
+
+void BidirectionalDijkstra::reset(Side &side)
+{
+    for (auto v : side.touched)
+    {
+        side.distances[v] = FLT_MAX;
+        side.parents[v] = DIJKSTRA_NO_PARENT;
+    }
+    side.touched.clear();
+    side.queue.Clear();
+}
+
+void BidirectionalDijkstra::step(Side &side, const Side &other, float &best, int &meeting_vertex,
+                                 long long &settled)
+{
+    auto current_distance = side.queue.TopKey();
+    auto current_vertex = side.queue.Pop();
+    ++settled;
+
+    const auto &graph = *side.graph;
+    auto edge_end = graph.EdgesEnd(current_vertex);
+    for (auto edge = graph.EdgesBegin(current_vertex); edge < edge_end; ++edge)
+    {
+        auto v = graph.edge_array[edge];
+        auto candidate = current_distance + graph.weight_array[edge];
+
+        if (candidate < side.distances[v])
+        {
+            if (side.distances[v] == FLT_MAX)
+            {
+                side.touched.push_back(v);
+            }
+            side.distances[v] = candidate;
+            side.parents[v] = current_vertex;
+            side.queue.PushOrDecrease(v, candidate);
+        }
+
+        // The edge joins the two searches
+        if (other.distances[v] != FLT_MAX && candidate + other.distances[v] < best)
+        {
+            best = candidate + other.distances[v];
+            meeting_vertex = v;
+        }
+    }
+}
+
+PointToPointResult BidirectionalDijkstra::Query(int source_vertex, int target_vertex)
+{
+    PointToPointResult result;
+    result.settled = 0;
+
+    this->forward.distances[source_vertex] = 0.f;
+    this->forward.parents[source_vertex] = source_vertex;
+    this->forward.touched.push_back(source_vertex);
+    this->forward.queue.Push(source_vertex, 0.f);
+
+    this->backward.distances[target_vertex] = 0.f;
+    this->backward.parents[target_vertex] = target_vertex;
+    this->backward.touched.push_back(target_vertex);
+    this->backward.queue.Push(target_vertex, 0.f);
+
+    auto best = source_vertex == target_vertex ? 0.f : FLT_MAX;
+    auto meeting_vertex = source_vertex == target_vertex ? source_vertex : -1;
+
+    // --- Alternating searches; once a side runs dry every path has been seen
+    while (!this->forward.queue.Empty() && !this->backward.queue.Empty() &&
+           this->forward.queue.TopKey() + this->backward.queue.TopKey() < best)
+    {
+        if (this->forward.queue.TopKey() <= this->backward.queue.TopKey())
+        {
+            this->step(this->forward, this->backward, best, meeting_vertex, result.settled);
+        }
+        else
+        {
+            this->step(this->backward, this->forward, best, meeting_vertex, result.settled);
+        }
+    }
+
+    // --- Source ... meeting vertex along the forward tree, then on to the
+    // target along the backward one
+    result.distance = best;
+    if (meeting_vertex >= 0)
+    {
+        for (auto v = meeting_vertex; v != source_vertex; v = this->forward.parents[v])
+        {
+            result.path.push_back(v);
+        }
+        result.path.push_back(source_vertex);
+        std::reverse(result.path.begin(), result.path.end());
+
+        for (auto v = meeting_vertex; v != target_vertex; )
+        {
+            v = this->backward.parents[v];
+            result.path.push_back(v);
+        }
+    }
+
+    this->reset(this->forward);
+    this->reset(this->backward);
+    return result;
+}
+
+PointToPointResult dijkstra_point_to_point(const Graph &graph, int source_vertex, int target_vertex)
+{
+    BidirectionalDijkstra search(graph);
+    return search.Query(source_vertex, target_vertex);
+}
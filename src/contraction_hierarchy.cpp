@@ -0,0 +1,703 @@
+#include "src/point_to_point.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+
+#include <omp.h>
+
+// Vertices a witness search may settle before it gives up and the shortcut is added
+#define CH_WITNESS_SETTLED_LIMIT 50
+// The same for the simulated contractions that only rate a vertex
+#define CH_SIMULATION_SETTLED_LIMIT 10
+// Vertices with more in x out arc pairs are dense: they are neither
+// contracted nor expanded by witness searches, they stay in the core
+#define CH_DENSE_PAIRS_LIMIT 256
+// The contraction stops and leaves the rest as the core once the remaining
+// graph averages this many times the out-arcs per vertex of the input...
+#define CH_CORE_DEGREE_FACTOR 2
+// ...or the shortcuts outnumber the edges of the input this many times
+#define CH_CORE_SHORTCUT_FACTOR 2
+
+namespace
+{
+
+struct Arc
+{
+    int vertex;         // target of an out-arc, source of an in-arc
+    float weight;
+    int middle;
+};
+
+///
+/// The remaining graph during the contraction: out- and in-arcs of every
+/// vertex, at most one arc per ordered pair (the lightest)
+///
+struct RemainingGraph
+{
+    std::vector<std::vector<Arc>> out;
+    std::vector<std::vector<Arc>> in;
+
+    explicit RemainingGraph(const Graph &graph) : out(graph.vertex_array.size()), in(graph.vertex_array.size())
+    {
+        auto number_of_vertexes = static_cast<int>(graph.vertex_array.size());
+        for (auto u = 0; u < number_of_vertexes; ++u)
+        {
+            auto edge_end = graph.EdgesEnd(u);
+            for (auto edge = graph.EdgesBegin(u); edge < edge_end; ++edge)
+            {
+                auto v = graph.edge_array[edge];
+                if (v != u)
+                {
+                    this->AddOrLower(u, v, graph.weight_array[edge], -1);
+                }
+            }
+        }
+    }
+
+    bool Dense(int vertex) const
+    {
+        return static_cast<long long>(this->in[vertex].size()) * static_cast<long long>(this->out[vertex].size()) >
+               CH_DENSE_PAIRS_LIMIT;
+    }
+
+    // Returns true if the arc is new, false if an existing one was kept or lowered
+    bool AddOrLower(int from, int to, float weight, int middle)
+    {
+        lower(this->in[to], from, weight, middle);
+        return lower(this->out[from], to, weight, middle);
+    }
+
+    void Remove(std::vector<Arc> &arcs, int vertex)
+    {
+        for (auto i = 0ULL; i < arcs.size(); ++i)
+        {
+            if (arcs[i].vertex == vertex)
+            {
+                arcs[i] = arcs.back();
+                arcs.pop_back();
+                return;
+            }
+        }
+    }
+
+private:
+    static bool lower(std::vector<Arc> &arcs, int vertex, float weight, int middle)
+    {
+        for (auto &arc : arcs)
+        {
+            if (arc.vertex == vertex)
+            {
+                if (weight < arc.weight)
+                {
+                    arc.weight = weight;
+                    arc.middle = middle;
+                }
+                return false;
+            }
+        }
+        arcs.push_back(Arc{vertex, weight, middle});
+        return true;
+    }
+};
+
+struct Shortcut
+{
+    int from;
+    int to;
+    float weight;
+};
+
+///
+/// Bounded Dijkstra over the out-arcs of the remaining graph, per thread,
+/// reset through the touched vertices
+///
+class WitnessSearch
+{
+    std::vector<float> distances;
+    std::vector<char> targets;
+    std::vector<int> touched;
+    IndexedDaryHeap<float> queue;
+
+public:
+    explicit WitnessSearch(int number_of_vertexes) :
+        distances(number_of_vertexes, FLT_MAX), targets(number_of_vertexes, 0), queue(number_of_vertexes)
+    {
+    }
+
+    // Shortcuts contracting `vertex` needs; `blocked` vertices (the round) are
+    // not used by witness paths
+    void Shortcuts(const RemainingGraph &graph, int vertex, const std::vector<char> &blocked,
+                   std::vector<Shortcut> &shortcuts, int settled_limit = CH_WITNESS_SETTLED_LIMIT)
+    {
+        const auto &out = graph.out[vertex];
+        auto max_out = 0.f;
+        for (const auto &arc : out)
+        {
+            max_out = std::max(max_out, arc.weight);
+            this->targets[arc.vertex] = 1;
+        }
+        auto number_of_targets = static_cast<int>(out.size());
+
+        for (const auto &in_arc : graph.in[vertex])
+        {
+            auto u = in_arc.vertex;
+            this->run(graph, u, vertex, blocked, in_arc.weight + max_out, number_of_targets, settled_limit);
+
+            for (const auto &out_arc : out)
+            {
+                auto via = in_arc.weight + out_arc.weight;
+                if (out_arc.vertex != u && this->distances[out_arc.vertex] > via)
+                {
+                    shortcuts.push_back(Shortcut{u, out_arc.vertex, via});
+                }
+            }
+            this->reset();
+        }
+
+        for (const auto &arc : out)
+        {
+            this->targets[arc.vertex] = 0;
+        }
+    }
+
+private:
+    // Stops once every target is settled, the queue passes `limit` or
+    // `settled_limit` vertices are settled.  Dense vertices other than the
+    // source are settled but not expanded, their rows are what makes a
+    // search through them expensive
+    void run(const RemainingGraph &graph, int source_vertex, int avoided, const std::vector<char> &blocked,
+             float limit, int number_of_targets, int settled_limit)
+    {
+        this->distances[source_vertex] = 0.f;
+        this->touched.push_back(source_vertex);
+        this->queue.Push(source_vertex, 0.f);
+
+        for (auto settled = 0; !this->queue.Empty() && settled < settled_limit; ++settled)
+        {
+            if (this->queue.TopKey() > limit)
+            {
+                break;
+            }
+            auto current_distance = this->queue.TopKey();
+            auto current_vertex = this->queue.Pop();
+            if (this->targets[current_vertex] && --number_of_targets == 0)
+            {
+                break;
+            }
+            if (current_vertex != source_vertex && graph.Dense(current_vertex))
+            {
+                continue;
+            }
+
+            for (const auto &arc : graph.out[current_vertex])
+            {
+                auto v = arc.vertex;
+                auto candidate = current_distance + arc.weight;
+                if (v == avoided || blocked[v] || candidate > limit || candidate >= this->distances[v])
+                {
+                    continue;
+                }
+                if (this->distances[v] == FLT_MAX)
+                {
+                    this->touched.push_back(v);
+                }
+                this->distances[v] = candidate;
+                this->queue.PushOrDecrease(v, candidate);
+            }
+        }
+    }
+
+    void reset()
+    {
+        for (auto v : this->touched)
+        {
+            this->distances[v] = FLT_MAX;
+        }
+        this->touched.clear();
+        this->queue.Clear();
+    }
+};
+
+// Rows of the vertices in `arcs` as one CSR direction of the hierarchy
+void build_arcs(const std::vector<std::vector<Arc>> &rows, ContractionHierarchy::Arcs &arcs)
+{
+    arcs.vertex_array.assign(1, 0);
+    for (const auto &row : rows)
+    {
+        for (const auto &arc : row)
+        {
+            arcs.targets.push_back(arc.vertex);
+            arcs.weights.push_back(arc.weight);
+            arcs.middles.push_back(arc.middle);
+        }
+        arcs.vertex_array.push_back(static_cast<int>(arcs.targets.size()));
+    }
+}
+
+}
+
+ContractionHierarchy::ContractionHierarchy(const Graph &graph, Progress progress) :
+    ranks(graph.vertex_array.size(), -1), edge_flags(graph.vertex_array.size(), 0), shortcuts(0), rounds(0), core_vertexes(0), preprocessing_seconds(0.)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    auto number_of_vertexes = static_cast<int>(graph.vertex_array.size());
+
+    for (auto u = 0; u < number_of_vertexes; ++u)
+    {
+        auto edge_end = graph.EdgesEnd(u);
+        for (auto edge = graph.EdgesBegin(u); edge < edge_end; ++edge)
+        {
+            this->edge_flags[u] |= 1;
+            this->edge_flags[graph.edge_array[edge]] |= 2;
+        }
+    }
+
+    RemainingGraph remaining(graph);
+    std::vector<std::vector<Arc>> upward_rows(number_of_vertexes);
+    std::vector<std::vector<Arc>> downward_rows(number_of_vertexes);
+
+    std::vector<int> priorities(number_of_vertexes, 0);
+    std::vector<int> contracted_neighbours(number_of_vertexes, 0);
+    std::vector<char> in_round(number_of_vertexes, 0);
+    std::vector<char> stale(number_of_vertexes, 1);
+
+    std::vector<int> active(number_of_vertexes);
+    for (auto v = 0; v < number_of_vertexes; ++v)
+    {
+        active[v] = v;
+    }
+
+    std::vector<int> round;
+    std::vector<std::vector<Shortcut>> round_shortcuts;
+    auto next_rank = 0;
+
+    // One witness search per thread for the whole contraction, each holds O(V) scratch
+    std::vector<WitnessSearch> searches(omp_get_max_threads(), WitnessSearch(number_of_vertexes));
+
+    auto input_arcs = 0LL;
+    for (const auto &arcs : remaining.out)
+    {
+        input_arcs += static_cast<long long>(arcs.size());
+    }
+    auto core_arcs_per_vertex = CH_CORE_DEGREE_FACTOR *
+                                std::max(1., static_cast<double>(input_arcs) / std::max(1, number_of_vertexes));
+
+    // Stop at a dense core: contracting it would add shortcuts faster than it
+    // removes vertices.  Checked after every contracted vertex, not per round
+    auto remaining_arcs = input_arcs;
+    auto number_of_active = static_cast<long long>(active.size());
+    auto core_reached = [&]()
+    {
+        return remaining_arcs > core_arcs_per_vertex * number_of_active ||
+               this->shortcuts > CH_CORE_SHORTCUT_FACTOR * input_arcs;
+    };
+
+    while (!active.empty() && !core_reached())
+    {
+        // --- Priorities of the vertices whose neighbourhood changed
+        #pragma omp parallel
+        {
+            auto &search = searches[omp_get_thread_num()];
+            std::vector<Shortcut> simulated;
+
+            #pragma omp for schedule(dynamic, 64)
+            for (auto i = 0LL; i < number_of_active; ++i)
+            {
+                auto v = active[i];
+                if (!stale[v] || remaining.Dense(v))
+                {
+                    continue;
+                }
+                simulated.clear();
+                search.Shortcuts(remaining, v, in_round, simulated, CH_SIMULATION_SETTLED_LIMIT);
+                auto removed = static_cast<long long>(remaining.in[v].size() + remaining.out[v].size());
+                priorities[v] = static_cast<int>(static_cast<long long>(simulated.size()) - removed) +
+                                contracted_neighbours[v];
+                stale[v] = 0;
+            }
+        }
+
+        // --- Independent set: vertices below all their neighbours, ties to
+        // the smaller id; dense vertices neither join nor compete
+        auto below = [&priorities, &remaining](int v, int u)
+        {
+            return remaining.Dense(u) || priorities[v] < priorities[u] || (priorities[v] == priorities[u] && v < u);
+        };
+        round.clear();
+        for (auto v : active)
+        {
+            if (remaining.Dense(v))
+            {
+                continue;
+            }
+            auto minimum = true;
+            for (const auto &arc : remaining.out[v])
+            {
+                minimum = minimum && below(v, arc.vertex);
+            }
+            for (const auto &arc : remaining.in[v])
+            {
+                minimum = minimum && below(v, arc.vertex);
+            }
+            if (minimum)
+            {
+                round.push_back(v);
+                in_round[v] = 1;
+            }
+        }
+        if (round.empty())
+        {
+            // Only dense vertices are left
+            break;
+        }
+
+        // --- Witness searches of the round, in parallel
+        auto round_size = static_cast<long long>(round.size());
+        round_shortcuts.resize(round.size());
+        #pragma omp parallel
+        {
+            auto &search = searches[omp_get_thread_num()];
+
+            #pragma omp for schedule(dynamic, 16)
+            for (auto i = 0LL; i < round_size; ++i)
+            {
+                round_shortcuts[i].clear();
+                search.Shortcuts(remaining, round[i], in_round, round_shortcuts[i]);
+            }
+        }
+
+        // --- Contraction: the arcs become hierarchy rows, the shortcuts go in.
+        // Once the core is reached the rest of the round stays uncontracted;
+        // its witness searches avoided more vertices than needed, which only
+        // adds shortcuts, so the contracted part is still correct
+        for (auto i = 0LL; i < round_size; ++i)
+        {
+            auto v = round[i];
+            in_round[v] = 0;
+            if (core_reached())
+            {
+                continue;
+            }
+
+            this->ranks[v] = next_rank++;
+            upward_rows[v] = remaining.out[v];
+            downward_rows[v] = remaining.in[v];
+            remaining_arcs -= static_cast<long long>(remaining.out[v].size() + remaining.in[v].size());
+            --number_of_active;
+
+            for (const auto &arc : remaining.out[v])
+            {
+                remaining.Remove(remaining.in[arc.vertex], v);
+                ++contracted_neighbours[arc.vertex];
+                stale[arc.vertex] = 1;
+            }
+            for (const auto &arc : remaining.in[v])
+            {
+                remaining.Remove(remaining.out[arc.vertex], v);
+                ++contracted_neighbours[arc.vertex];
+                stale[arc.vertex] = 1;
+            }
+            remaining.out[v].clear();
+            remaining.out[v].shrink_to_fit();
+            remaining.in[v].clear();
+            remaining.in[v].shrink_to_fit();
+
+            for (const auto &shortcut : round_shortcuts[i])
+            {
+                if (remaining.AddOrLower(shortcut.from, shortcut.to, shortcut.weight, v))
+                {
+                    ++remaining_arcs;
+                }
+            }
+            this->shortcuts += static_cast<long long>(round_shortcuts[i].size());
+        }
+
+        active.erase(std::remove_if(active.begin(), active.end(), [this](int v) { return this->ranks[v] >= 0; }),
+                     active.end());
+        ++this->rounds;
+
+        if (progress)
+        {
+            progress(next_rank, number_of_vertexes, this->shortcuts);
+        }
+    }
+
+    // --- The core ranks above the contracted vertices and keeps its arcs both
+    // ways, so the upward searches continue through it as plain Dijkstra
+    this->core_vertexes = static_cast<int>(active.size());
+    for (auto v : active)
+    {
+        this->ranks[v] = next_rank++;
+        upward_rows[v] = remaining.out[v];
+        downward_rows[v] = remaining.in[v];
+    }
+    if (progress && !active.empty())
+    {
+        progress(next_rank, number_of_vertexes, this->shortcuts);
+    }
+
+    build_arcs(upward_rows, this->upward);
+    build_arcs(downward_rows, this->downward);
+
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    this->preprocessing_seconds = elapsed.count();
+}
+
+size_t ContractionHierarchy::Bytes() const
+{
+    const Arcs *directions[] = { &this->upward, &this->downward };
+    size_t bytes = this->ranks.size() * sizeof(int) + this->edge_flags.size();
+    for (auto arcs : directions)
+    {
+        bytes += arcs->vertex_array.size() * sizeof(int) + arcs->targets.size() * (2 * sizeof(int) + sizeof(float));
+    }
+    return bytes;
+}
+
+void ContractionHierarchy::Unpack(int from, int to, int middle, std::vector<int> &path) const
+{
+    if (middle < 0)
+    {
+        path.push_back(to);
+        return;
+    }
+
+    // from -> middle is a downward arc of the middle, middle -> to an upward one
+    for (auto arc = this->downward.vertex_array[middle]; arc < this->downward.vertex_array[middle + 1]; ++arc)
+    {
+        if (this->downward.targets[arc] == from)
+        {
+            this->Unpack(from, middle, this->downward.middles[arc], path);
+            break;
+        }
+    }
+    for (auto arc = this->upward.vertex_array[middle]; arc < this->upward.vertex_array[middle + 1]; ++arc)
+    {
+        if (this->upward.targets[arc] == to)
+        {
+            this->Unpack(middle, to, this->upward.middles[arc], path);
+            break;
+        }
+    }
+}
+
+ContractionHierarchySearch::ContractionHierarchySearch(const ContractionHierarchy &hierarchy) :
+    hierarchy(hierarchy), core_rank(hierarchy.NumberOfVertexes() - hierarchy.CoreVertexes())
+{
+    auto number_of_vertexes = hierarchy.NumberOfVertexes();
+
+    Side *sides[] = { &this->forward, &this->backward };
+    for (auto side : sides)
+    {
+        side->labels.resize(number_of_vertexes);
+        for (auto v = 0; v < number_of_vertexes; ++v)
+        {
+            side->labels[v] = Label{FLT_MAX, DIJKSTRA_NO_PARENT, -1, hierarchy.Rank(v)};
+        }
+        side->queue.Resize(number_of_vertexes);
+        side->top_rank = -1;
+        side->rank_limit = INT_MAX;
+    }
+    this->forward.arcs = &hierarchy.Upward();
+    this->backward.arcs = &hierarchy.Downward();
+}
+
+void ContractionHierarchySearch::reach(Side &side, int vertex, float distance, int parent, int middle)
+{
+    auto &label = side.labels[vertex];
+    auto in_core = label.rank >= this->core_rank;
+    if (label.distance == FLT_MAX)
+    {
+        side.touched.push_back(vertex);
+        side.top_rank = std::max(side.top_rank, label.rank);
+        if (in_core)
+        {
+            side.entries.push_back(vertex);
+        }
+    }
+    label.distance = distance;
+    label.parent = parent;
+    label.middle = middle;
+    if (!in_core)
+    {
+        side.queue.PushOrDecrease(vertex, distance);
+    }
+}
+
+PointToPointResult ContractionHierarchySearch::Query(int source_vertex, int target_vertex)
+{
+    PointToPointResult result;
+    result.settled = 0;
+
+    // Nothing leaves the source or enters the target
+    if (source_vertex != target_vertex &&
+        (!this->hierarchy.HasOutEdges(source_vertex) || !this->hierarchy.HasInEdges(target_vertex)))
+    {
+        result.distance = FLT_MAX;
+        return result;
+    }
+
+    this->reach(this->forward, source_vertex, 0.f, DIJKSTRA_NO_PARENT, -1);
+    this->reach(this->backward, target_vertex, 0.f, DIJKSTRA_NO_PARENT, -1);
+
+    auto best = FLT_MAX;
+    auto meeting_vertex = -1;
+
+    // --- Upward searches below the core; a side is done once its minimum
+    // reaches `best`, the core vertices it reaches are kept as entries.  A
+    // side that runs dry without entries can only meet the other at the
+    // vertices it touched, and ranks only grow along the arcs, so the other
+    // side need not expand anything above the highest of them
+    while (true)
+    {
+        Side *sides[] = { &this->forward, &this->backward };
+        for (auto side : sides)
+        {
+            auto &other = side == &this->forward ? this->backward : this->forward;
+            if (side->queue.Empty() && side->entries.empty())
+            {
+                other.rank_limit = side->top_rank;
+            }
+        }
+
+        auto forward_open = !this->forward.queue.Empty() && this->forward.queue.TopKey() < best;
+        auto backward_open = !this->backward.queue.Empty() && this->backward.queue.TopKey() < best;
+        if (!forward_open && !backward_open)
+        {
+            break;
+        }
+
+        auto use_forward = forward_open &&
+                           (!backward_open || this->forward.queue.TopKey() <= this->backward.queue.TopKey());
+        auto &side = use_forward ? this->forward : this->backward;
+        const auto &other = use_forward ? this->backward : this->forward;
+
+        auto current_distance = side.queue.TopKey();
+        auto current_vertex = side.queue.Pop();
+        ++result.settled;
+
+        auto other_distance = other.labels[current_vertex].distance;
+        if (other_distance != FLT_MAX && current_distance + other_distance < best)
+        {
+            best = current_distance + other_distance;
+            meeting_vertex = current_vertex;
+        }
+        if (side.labels[current_vertex].rank > side.rank_limit)
+        {
+            continue;
+        }
+
+        const auto &arcs = *side.arcs;
+        for (auto arc = arcs.vertex_array[current_vertex]; arc < arcs.vertex_array[current_vertex + 1]; ++arc)
+        {
+            auto v = arcs.targets[arc];
+            auto candidate = current_distance + arcs.weights[arc];
+            const auto &label = side.labels[v];
+            if (candidate < label.distance && label.rank <= side.rank_limit)
+            {
+                this->reach(side, v, candidate, current_vertex, arcs.middles[arc]);
+            }
+        }
+    }
+
+    // --- Bidirectional Dijkstra inside the core from the entries of both
+    // sides; the upward arcs of the core are its out-arcs, the downward ones
+    // its in-arcs, so the usual stopping rule holds
+    this->forward.queue.Clear();
+    this->backward.queue.Clear();
+    Side *sides[] = { &this->forward, &this->backward };
+    for (auto side : sides)
+    {
+        const auto &other = side == &this->forward ? this->backward : this->forward;
+        for (auto v : side->entries)
+        {
+            auto distance = side->labels[v].distance, other_distance = other.labels[v].distance;
+            side->queue.Push(v, distance);
+            if (other_distance != FLT_MAX && distance + other_distance < best)
+            {
+                best = distance + other_distance;
+                meeting_vertex = v;
+            }
+        }
+    }
+
+    while (!this->forward.queue.Empty() && !this->backward.queue.Empty() &&
+           this->forward.queue.TopKey() + this->backward.queue.TopKey() < best)
+    {
+        auto use_forward = this->forward.queue.TopKey() <= this->backward.queue.TopKey();
+        auto &side = use_forward ? this->forward : this->backward;
+        const auto &other = use_forward ? this->backward : this->forward;
+
+        auto current_distance = side.queue.TopKey();
+        auto current_vertex = side.queue.Pop();
+        ++result.settled;
+
+        const auto &arcs = *side.arcs;
+        for (auto arc = arcs.vertex_array[current_vertex]; arc < arcs.vertex_array[current_vertex + 1]; ++arc)
+        {
+            auto v = arcs.targets[arc];
+            auto candidate = current_distance + arcs.weights[arc];
+            auto &label = side.labels[v];
+            if (candidate < label.distance)
+            {
+                if (label.distance == FLT_MAX)
+                {
+                    side.touched.push_back(v);
+                }
+                label.distance = candidate;
+                label.parent = current_vertex;
+                label.middle = arcs.middles[arc];
+                side.queue.PushOrDecrease(v, candidate);
+            }
+
+            // The arc joins the two searches
+            auto other_distance = other.labels[v].distance;
+            if (other_distance != FLT_MAX && candidate + other_distance < best)
+            {
+                best = candidate + other_distance;
+                meeting_vertex = v;
+            }
+        }
+    }
+
+    // --- Unpack source ... meeting vertex, then meeting vertex ... target
+    result.distance = best;
+    if (meeting_vertex >= 0)
+    {
+        std::vector<int> upward_path;
+        for (auto v = meeting_vertex; v != source_vertex; v = this->forward.labels[v].parent)
+        {
+            upward_path.push_back(v);
+        }
+        upward_path.push_back(source_vertex);
+
+        result.path.push_back(source_vertex);
+        for (auto i = upward_path.size() - 1; i > 0; --i)
+        {
+            this->hierarchy.Unpack(upward_path[i], upward_path[i - 1],
+                                   this->forward.labels[upward_path[i - 1]].middle, result.path);
+        }
+        for (auto v = meeting_vertex; v != target_vertex; v = this->backward.labels[v].parent)
+        {
+            this->hierarchy.Unpack(v, this->backward.labels[v].parent, this->backward.labels[v].middle, result.path);
+        }
+    }
+
+    for (auto side : sides)
+    {
+        for (auto v : side->touched)
+        {
+            auto &label = side->labels[v];
+            label.distance = FLT_MAX;
+            label.parent = DIJKSTRA_NO_PARENT;
+            label.middle = -1;
+        }
+        side->touched.clear();
+        side->entries.clear();
+        side->top_rank = -1;
+        side->rank_limit = INT_MAX;
+        side->queue.Clear();
+    }
+    return result;
+}
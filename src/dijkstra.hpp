@@ -10,6 +10,8 @@
 #endif
 
 #include "common/graph.hpp"
+#include "common/compressed_graph.hpp"
+#include "common/csr_graph.hpp"
 
 
 typedef enum ocl_init_result_e
@@ -21,16 +23,123 @@ typedef enum ocl_init_result_e
     OCL_INIT_NO_PLATFORM,
 } ocl_init_result_t;
 
+///
+/// Every backend can optionally fill `parents` with the shortest path tree:
+/// parents[source] == source, parents[v] == DIJKSTRA_NO_PARENT for unreachable
+/// vertices, otherwise the predecessor of v on a shortest path.
+///
+#define DIJKSTRA_NO_PARENT (-1)
+
 std::vector<float> dijkstra_sequential(const Graph &graph,
-                                       int source_vertex);
+                                       int source_vertex,
+                                       std::vector<int> *parents = nullptr);
+
+std::vector<float> dijkstra_sequential_csr(const Graph &graph,
+                                           int source_vertex,
+                                           std::vector<int> *parents = nullptr);
+
+std::vector<float> dijkstra_sequential_heap(const Graph &graph,
+                                            int source_vertex,
+                                            std::vector<int> *parents = nullptr);
+
+// The heap engine decoding the compressed rows on the fly, for A/B runs against dijkstra_sequential_heap
+std::vector<float> dijkstra_compressed_heap(const CompressedGraph &graph,
+                                            int source_vertex,
+                                            std::vector<int> *parents = nullptr);
+
+///
+/// Engines for integer costs (see common/csr_graph.hpp), exact and free of the
+/// float rounding that makes the other backends differ in the last bits.
+/// dijkstra_integer_heap is the heap engine instantiated for integer costs; the
+/// radix heap and Dial's buckets rely on integer keys that never decrease.
+/// dijkstra_dial needs a bucket per weight value and uses the radix heap if
+/// the largest weight is above DIAL_MAX_BUCKETS.
+///
+#define DIAL_MAX_BUCKETS (1u << 20)
+
+std::vector<IntegerDistance> dijkstra_integer_heap(const IntegerGraph &graph,
+                                                   int source_vertex,
+                                                   std::vector<int> *parents = nullptr);
+
+std::vector<IntegerDistance> dijkstra_radix_heap(const IntegerGraph &graph,
+                                                 int source_vertex,
+                                                 std::vector<int> *parents = nullptr);
+
+std::vector<IntegerDistance> dijkstra_dial(const IntegerGraph &graph,
+                                           int source_vertex,
+                                           std::vector<int> *parents = nullptr);
+
+///
+/// Throughput path for many queries on one graph: the heap engine run for all
+/// `sources` concurrently, one query per thread at a time.  Returns a
+/// source-major matrix, row i (V floats) holds the distances from sources[i].
+///
+std::vector<float> dijkstra_batch(const Graph &graph, const std::vector<int> &sources);
 
 std::vector<float> dijkstra_omp(const Graph &graph,
-                                int source_vertex);
+                                int source_vertex,
+                                std::vector<int> *parents = nullptr);
+
+std::vector<float> dijkstra_omp_csr(const Graph &graph,
+                                    int source_vertex,
+                                    std::vector<int> *parents = nullptr);
+
+// Delta-stepping; without `delta` the bucket width is max weight / average degree,
+// a `delta` below max weight / DELTA_MAX_BUCKETS is widened to that
+std::vector<float> dijkstra_delta_stepping(const Graph &graph,
+                                           int source_vertex,
+                                           std::vector<int> *parents = nullptr);
+
+std::vector<float> dijkstra_delta_stepping(const Graph &graph,
+                                           int source_vertex,
+                                           float delta,
+                                           std::vector<int> *parents = nullptr);
+
+// The two-kernel GPU algorithm (mask, cost, updating cost) on OpenMP threads, with a sparse frontier
+std::vector<float> dijkstra_harish_narayanan(const Graph &graph,
+                                             int source_vertex,
+                                             std::vector<int> *parents = nullptr);
+
+///
+/// Work counters of dijkstra_multiqueue.  The relaxed queue lets a vertex be
+/// expanded before its distance is final and again later, and leaves stale
+/// entries behind; both are work an exact priority queue would not do.
+///
+struct MultiQueueStats
+{
+    long long pops;
+    long long stale_pops;       // entries superseded by a shorter distance, skipped
+    long long expansions;       // edge scans of popped vertices
+    long long reached;          // vertices with a finite distance, one expansion each is the minimum
+
+    long long WastedWork() const { return this->stale_pops + this->expansions - this->reached; }
+};
+
+// Asynchronous SSSP: OpenMP threads pop vertices from a MultiQueue and relax with atomic distance updates
+std::vector<float> dijkstra_multiqueue(const Graph &graph,
+                                       int source_vertex,
+                                       std::vector<int> *parents = nullptr,
+                                       MultiQueueStats *stats = nullptr);
 
 ocl_init_result_t dijkstra_init_contexts(cl_context &gpu_context, cl_context &cpu_context);
 
-std::vector<float> dijkstra_opencl(const Graph &graph, int source_vertex, cl_context &opencl_context);
+std::vector<float> dijkstra_opencl(const Graph &graph, int source_vertex, cl_context &opencl_context,
+                                   std::vector<int> *parents = nullptr);
+
+// OpenCL with frontier-compacted kernels, the work per iteration follows the frontier instead of V
+std::vector<float> dijkstra_opencl_frontier(const Graph &graph, int source_vertex, cl_context &opencl_context,
+                                            std::vector<int> *parents = nullptr);
+
+std::vector<float> dijkstra_cuda(const Graph &graph, int sourceVertex, std::vector<int> *parents = nullptr);
+
+std::vector<float> dijkstra_acc(const Graph &graph, int source_vertex, std::vector<int> *parents = nullptr);
 
-std::vector<float> dijkstra_cuda(const Graph &graph, int sourceVertex);
+// Vertices from `source_vertex` to `target_vertex` along `parents`, empty if the target is unreachable
+std::vector<int> dijkstra_path(const std::vector<int> &parents, int source_vertex, int target_vertex);
 
-std::vector<float> dijkstra_acc(const Graph &graph, int source_vertex);
\ No newline at end of file
+///
+/// Shortest path tree for backends that only compute distances: parents[v] = u
+/// for some edge u -> v with weight w > 0, d[u] + w == d[v] and d[u] < d[v]
+///
+void dijkstra_parents_from_distances(const Graph &graph, int source_vertex, const std::vector<float> &distances,
+                                     std::vector<int> &parents);
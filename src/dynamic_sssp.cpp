@@ -0,0 +1,134 @@
+#include "src/dynamic_sssp.hpp"
+
+DynamicSssp::DynamicSssp(const Graph &graph, int source_vertex) : graph(graph), source_vertex(source_vertex)
+{
+    auto number_of_vertexes = static_cast<int>(graph.vertex_array.size());
+
+    this->distances = dijkstra_sequential_heap(graph, source_vertex, &this->parents);
+    this->invalid.assign(number_of_vertexes, 0);
+    this->queue.Resize(number_of_vertexes);
+}
+
+void DynamicSssp::invalidate_subtree(int root, RepairStats &stats)
+{
+    if (this->invalid[root])
+    {
+        return;
+    }
+
+    // The children of x are the out-neighbours whose parent is x
+    auto first = this->invalidated.size();
+    this->invalid[root] = 1;
+    this->invalidated.push_back(root);
+    for (auto i = first; i < this->invalidated.size(); ++i)
+    {
+        auto x = this->invalidated[i];
+        auto edge_end = this->graph.EdgesEnd(x);
+        for (auto edge = this->graph.EdgesBegin(x); edge < edge_end; ++edge)
+        {
+            auto y = this->graph.edge_array[edge];
+            if (this->parents[y] == x && !this->invalid[y])
+            {
+                this->invalid[y] = 1;
+                this->invalidated.push_back(y);
+            }
+        }
+        stats.scanned += edge_end - this->graph.EdgesBegin(x);
+    }
+}
+
+RepairStats DynamicSssp::Repair(const std::vector<EdgeWeightUpdate> &updates)
+{
+    RepairStats stats;
+    stats.invalidated = stats.settled = stats.scanned = 0;
+
+    // --- Increases: a heavier tree edge no longer supports the distance of
+    // its target, checked against the distances before the batch
+    for (const auto &update : updates)
+    {
+        auto u = this->graph.EdgeSource(update.edge);
+        auto v = this->graph.edge_array[update.edge];
+        auto weight = this->graph.weight_array[update.edge];
+        if (v != this->source_vertex && this->parents[v] == u && this->distances[u] + weight > this->distances[v])
+        {
+            this->invalidate_subtree(v, stats);
+        }
+    }
+    stats.invalidated = static_cast<long long>(this->invalidated.size());
+
+    // --- The cut vertices start over from their in-edges outside of the cut
+    const auto &reverse = this->graph.Reverse();
+    for (auto v : this->invalidated)
+    {
+        this->distances[v] = FLT_MAX;
+        this->parents[v] = DIJKSTRA_NO_PARENT;
+    }
+    for (auto v : this->invalidated)
+    {
+        auto edge_end = reverse.EdgesEnd(v);
+        for (auto edge = reverse.EdgesBegin(v); edge < edge_end; ++edge)
+        {
+            auto u = reverse.edge_array[edge];
+            if (this->invalid[u] || this->distances[u] == FLT_MAX)
+            {
+                continue;
+            }
+            auto candidate = this->distances[u] + reverse.weight_array[edge];
+            if (candidate < this->distances[v])
+            {
+                this->distances[v] = candidate;
+                this->parents[v] = u;
+                this->queue.PushOrDecrease(v, candidate);
+            }
+        }
+        stats.scanned += edge_end - reverse.EdgesBegin(v);
+    }
+
+    // --- Decreases: a lighter edge that improves its target
+    for (const auto &update : updates)
+    {
+        auto u = this->graph.EdgeSource(update.edge);
+        auto v = this->graph.edge_array[update.edge];
+        if (this->distances[u] == FLT_MAX)
+        {
+            continue;
+        }
+        auto candidate = this->distances[u] + this->graph.weight_array[update.edge];
+        if (candidate < this->distances[v])
+        {
+            this->distances[v] = candidate;
+            this->parents[v] = u;
+            this->queue.PushOrDecrease(v, candidate);
+        }
+    }
+    stats.scanned += static_cast<long long>(updates.size());
+
+    // --- Dijkstra from the seeds; every vertex it improves is pushed again
+    while (!this->queue.Empty())
+    {
+        auto current_distance = this->queue.TopKey();
+        auto current_vertex = this->queue.Pop();
+        ++stats.settled;
+
+        auto edge_end = this->graph.EdgesEnd(current_vertex);
+        for (auto edge = this->graph.EdgesBegin(current_vertex); edge < edge_end; ++edge)
+        {
+            auto v = this->graph.edge_array[edge];
+            auto candidate = current_distance + this->graph.weight_array[edge];
+            if (candidate < this->distances[v])
+            {
+                this->distances[v] = candidate;
+                this->parents[v] = current_vertex;
+                this->queue.PushOrDecrease(v, candidate);
+            }
+        }
+        stats.scanned += edge_end - this->graph.EdgesBegin(current_vertex);
+    }
+
+    for (auto v : this->invalidated)
+    {
+        this->invalid[v] = 0;
+    }
+    this->invalidated.clear();
+    return stats;
+}
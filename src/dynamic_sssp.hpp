@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+#include "src/dijkstra.hpp"
+#include "common/dary_heap.hpp"
+
+///
+/// Work counters of one DynamicSssp::Repair
+///
+struct RepairStats
+{
+    long long invalidated;      // vertices of the subtrees cut off by weight increases
+    long long settled;          // vertices popped by the propagation
+    long long scanned;          // edges looked at, subtree walks and in-edges included
+};
+
+///
+/// Single-source distances and shortest path tree kept current while edge
+/// weights change.  After Graph::UpdateWeights, Repair brings the result in
+/// line with the new weights at a cost that follows the affected region:
+///
+///  - a tree edge u -> v that got heavier cuts off the subtree of v, found by
+///    walking the out-edges of the subtree along `parents`; those vertices
+///    lose their distance and are seeded from their in-edges (over
+///    Graph::Reverse()) that come from outside the cut;
+///  - an edge u -> v that got lighter and now improves v seeds v;
+///  - a Dijkstra from the seeds then propagates every improvement
+///    (Ramalingam and Reps) and settles the cut vertices again.
+///
+/// The distances are the same floats a full run gives, they are sums along
+/// the same paths.  The first Repair builds Graph::Reverse() if the graph has
+/// none, which costs O(E) once.  Scratch is reset through the vertices the
+/// repair touched; not thread-safe.
+///
+class DynamicSssp
+{
+public:
+    // Runs dijkstra_sequential_heap from the source
+    DynamicSssp(const Graph &graph, int source_vertex);
+
+    // `updates` are the edges changed since the last call; the graph must
+    // already carry their new weights, which are read from it (an edge may
+    // appear more than once)
+    RepairStats Repair(const std::vector<EdgeWeightUpdate> &updates);
+
+    const std::vector<float> &Distances() const { return this->distances; }
+    const std::vector<int> &Parents() const { return this->parents; }
+
+private:
+    const Graph &graph;
+    int source_vertex;
+    std::vector<float> distances;
+    std::vector<int> parents;
+    std::vector<char> invalid;
+    std::vector<int> invalidated;
+    IndexedDaryHeap<float> queue;
+
+    void invalidate_subtree(int root, RepairStats &stats);
+};
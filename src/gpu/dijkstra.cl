@@ -16,6 +16,27 @@
 //
 
 
+///
+/// Atomic min on a float, as a compare-and-swap loop on its bit pattern.
+/// Returns true if `value` was stored.
+///
+inline bool atomicMinFloat(volatile __global float *address, float value)
+{
+    volatile __global int *bits = (volatile __global int *)address;
+    int old = *bits;
+
+    while (value < as_float(old))
+    {
+        int assumed = old;
+        old = atomic_cmpxchg(bits, assumed, as_int(value));
+        if (old == assumed)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 ///
 /// This is part 1 of the Kernel from Algorithm 4 in the paper
 ///
@@ -54,10 +75,10 @@ __kernel  void OCL_SSSP_KERNEL1(__global int *vertexArray,
             //  found that the correct thing to do was weightArray[edge].  I think
             //  this was a typo in the paper.  Either that, or I misunderstood
             //  the data structure.
-            if (updatingCostArray[nid] > (costArray[tid] + weightArray[edge]))
-            {
-                updatingCostArray[nid] = (costArray[tid] + weightArray[edge]);
-            }
+            //
+            // A plain compare-and-store here loses updates when two
+            // frontier vertices share a neighbour
+            atomicMinFloat(&updatingCostArray[nid], costArray[tid] + weightArray[edge]);
         }
     }
 }
@@ -65,9 +86,13 @@ __kernel  void OCL_SSSP_KERNEL1(__global int *vertexArray,
 ///
 /// This is part 2 of the Kernel from Algorithm 5 in the paper.
 ///
+///
+/// `changedCount` counts the vertices put back into the mask, i.e. the size of
+/// the next frontier; the host only reads this counter to detect convergence.
+///
 __kernel  void OCL_SSSP_KERNEL2(__global int *vertexArray, __global int *edgeArray, __global float *weightArray,
                                 __global int *maskArray, __global float *costArray, __global float *updatingCostArray,
-                                int vertexCount)
+                                int vertexCount, __global int *changedCount)
 {
     // access thread id
     int tid = get_global_id(0);
@@ -77,12 +102,46 @@ __kernel  void OCL_SSSP_KERNEL2(__global int *vertexArray, __global int *edgeArr
     {
         costArray[tid] = updatingCostArray[tid];
         maskArray[tid] = 1;
+        atomic_inc(changedCount);
     }
 
     updatingCostArray[tid] = costArray[tid];
 }
 
 
+///
+/// Shortest path tree from the final costs: every vertex makes itself the
+/// parent of the neighbours it reaches over a tight edge.  Any tight edge is
+/// a valid parent, so racing writes to the same parent are harmless.
+///
+__kernel void OCL_SSSP_PARENTS(__global int *vertexArray, __global int *edgeArray, __global float *weightArray,
+                               __global float *costArray, __global int *parentArray, int sourceVertex,
+                               int vertexCount, int edgeCount)
+{
+    // access thread id
+    int tid = get_global_id(0);
+
+    if (tid >= vertexCount || costArray[tid] == FLT_MAX)
+    {
+        return;
+    }
+
+    int edgeStart = vertexArray[tid];
+    int edgeEnd = (tid + 1 < vertexCount) ? vertexArray[tid + 1] : edgeCount;
+
+    for (int edge = edgeStart; edge < edgeEnd; edge++)
+    {
+        int nid = edgeArray[edge];
+        float cost = costArray[tid] + weightArray[edge];
+
+        if (nid != sourceVertex && weightArray[edge] > 0.0f && cost == costArray[nid] && costArray[tid] < costArray[nid])
+        {
+            parentArray[nid] = tid;
+        }
+    }
+}
+
+
 ///
 /// Kernel to initialize buffers
 ///
@@ -107,3 +166,72 @@ __kernel void initializeBuffers( __global int *maskArray, __global float *costAr
 
 }
 
+
+///
+/// Frontier-compacted SSSP.  Instead of one work-item per vertex and a mask,
+/// every launch processes an explicit queue of the vertices whose cost went
+/// down in the previous launch, so the work per iteration is proportional to
+/// the frontier and not to V.
+///
+/// queuedArray[v] is 1 while v sits in the next frontier; it deduplicates the
+/// atomic append, so a frontier never holds more than V vertices.
+///
+__kernel void OCL_FRONTIER_INIT(__global float *costArray, __global int *queuedArray, __global int *frontier,
+                                int sourceVertex, int vertexCount)
+{
+    // access thread id
+    int tid = get_global_id(0);
+
+    if (tid >= vertexCount)
+    {
+        return;
+    }
+
+    costArray[tid] = (tid == sourceVertex) ? 0.0f : FLT_MAX;
+    queuedArray[tid] = (tid == sourceVertex) ? 1 : 0;
+
+    if (tid == 0)
+    {
+        frontier[0] = sourceVertex;
+    }
+}
+
+///
+/// Relax the outgoing edges of frontier[0 .. frontierSize) and append every
+/// neighbour whose cost went down to nextFrontier
+///
+__kernel void OCL_FRONTIER_RELAX(__global int *vertexArray, __global int *edgeArray, __global float *weightArray,
+                                 __global float *costArray, __global int *queuedArray,
+                                 __global int *frontier, int frontierSize,
+                                 __global int *nextFrontier, __global int *nextFrontierSize,
+                                 int vertexCount, int edgeCount)
+{
+    // access thread id
+    int tid = get_global_id(0);
+
+    if (tid >= frontierSize)
+    {
+        return;
+    }
+
+    int vertex = frontier[tid];
+
+    // Leave the next frontier before reading the cost: an update that lands
+    // after the read then queues the vertex again, one that lands before it
+    // is picked up by the read
+    atomic_xchg(&queuedArray[vertex], 0);
+    float cost = as_float(atomic_or((volatile __global int *)&costArray[vertex], 0));
+
+    int edgeStart = vertexArray[vertex];
+    int edgeEnd = (vertex + 1 < vertexCount) ? vertexArray[vertex + 1] : edgeCount;
+
+    for (int edge = edgeStart; edge < edgeEnd; edge++)
+    {
+        int nid = edgeArray[edge];
+
+        if (atomicMinFloat(&costArray[nid], cost + weightArray[edge]) && atomic_xchg(&queuedArray[nid], 1) == 0)
+        {
+            nextFrontier[atomic_inc(nextFrontierSize)] = nid;
+        }
+    }
+}
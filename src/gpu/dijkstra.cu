@@ -1,19 +1,10 @@
 #include "src/dijkstra.hpp"
+#include "src/adaptive_batch.hpp"
 
 #include "Utilities.cuh"
 
-#define NUM_ASYNCHRONOUS_ITERATIONS 20  // Number of async loop iterations before attempting to read results back
-
 #define BLOCK_SIZE 16
 
-bool allFinalizedVertices(bool * finalizedVertices,
-                          int numVertices) {
-
-    for (int i = 0; i < numVertices; i++)  if (finalizedVertices[i] == true) { return false; }
-
-    return true;
-}
-
 __global__ void initializeArrays(bool  * __restrict__ d_finalizedVertices,
                                  float * __restrict__ d_shortestDistances,
                                  float * __restrict__ d_updatingShortestDistances,
@@ -89,7 +80,8 @@ __global__  void Kernel2(const int   * __restrict__ vertexArray,
                          bool  * __restrict__ finalizedVertices,
                          float * __restrict__ shortestDistances,
                          float * __restrict__ updatingShortestDistances,
-                         const int numVertices) {
+                         const int numVertices,
+                         int   * __restrict__ changedCount) {
 
     int tid = blockIdx.x * blockDim.x + threadIdx.x;
 
@@ -102,12 +94,51 @@ __global__  void Kernel2(const int   * __restrict__ vertexArray,
     {
         shortestDistances[tid] = updatingShortestDistances[tid];
         finalizedVertices[tid] = true;
+        // --- Size of the next frontier, the host reads it instead of the mask
+        atomicAdd(changedCount, 1);
     }
 
     updatingShortestDistances[tid] = shortestDistances[tid];
 }
 
-std::vector<float> dijkstra_cuda(const Graph &graph, int sourceVertex)
+///
+/// Shortest path tree from the final distances: every vertex makes itself the
+/// parent of the neighbours it reaches over a tight edge.  Any tight edge is a
+/// valid parent, so racing writes to the same parent are harmless.
+///
+__global__  void computeParents(const int   * __restrict__ vertexArray,
+                                const int   * __restrict__ edgeArray,
+                                const float * __restrict__ weightArray,
+                                const float * __restrict__ shortestDistances,
+                                int * __restrict__ parents,
+                                const int sourceVertex,
+                                const int numVertices,
+                                const int numEdges)
+{
+    int tid = blockIdx.x * blockDim.x + threadIdx.x;
+
+    if (tid >= numVertices || shortestDistances[tid] == FLT_MAX)
+    {
+        return;
+    }
+
+    int edgeStart = vertexArray[tid];
+    int edgeEnd = (tid + 1 < numVertices) ? vertexArray[tid + 1] : numEdges;
+
+    for (int edge = edgeStart; edge < edgeEnd; edge++)
+    {
+        int nid = edgeArray[edge];
+        float distance = shortestDistances[tid] + weightArray[edge];
+
+        if (nid != sourceVertex && weightArray[edge] > 0.f && distance == shortestDistances[nid] &&
+            shortestDistances[tid] < shortestDistances[nid])
+        {
+            parents[nid] = tid;
+        }
+    }
+}
+
+std::vector<float> dijkstra_cuda(const Graph &graph, int sourceVertex, std::vector<int> *parents)
 {
     // --- Create device-side adjacency-list, namely, vertex array Va, edge array Ea and weight array Wa from G(V,E,W)
     int   * d_vertexArray; gpuErrchk(cudaMalloc(&d_vertexArray, sizeof(int)   * graph.vertex_array.size()));
@@ -124,7 +155,7 @@ std::vector<float> dijkstra_cuda(const Graph &graph, int sourceVertex)
     float * d_shortestDistances;         gpuErrchk(cudaMalloc(&d_shortestDistances, sizeof(float) * graph.vertex_array.size()));
     float * d_updatingShortestDistances; gpuErrchk(cudaMalloc(&d_updatingShortestDistances, sizeof(float) * graph.vertex_array.size()));
 
-    bool * h_finalizedVertices = new bool[graph.vertex_array.size()];
+    int   * d_changedCount;              gpuErrchk(cudaMalloc(&d_changedCount, sizeof(int)));
 
     // --- Initialize mask Ma to false, cost array Ca and Updating cost array Ua to \u221e
     initializeArrays<<<iDivUp(graph.vertex_array.size(), BLOCK_SIZE), BLOCK_SIZE>>>(d_finalizedVertices,
@@ -133,17 +164,16 @@ std::vector<float> dijkstra_cuda(const Graph &graph, int sourceVertex)
                                                                                     sourceVertex,
                                                                                     graph.vertex_array.size());
     gpuErrchk(cudaPeekAtLastError());
-    gpuErrchk(cudaDeviceSynchronize());
 
-    // --- Read mask array from device -> host
-    gpuErrchk(cudaMemcpy(h_finalizedVertices, d_finalizedVertices, sizeof(bool) * graph.vertex_array.size(), cudaMemcpyDeviceToHost));
-
-    while (!allFinalizedVertices(h_finalizedVertices, graph.vertex_array.size()))
+    // --- In order to improve performance, we run a batch of iterations without reading anything back.  Only the last
+    //     iteration of a batch counts the vertices it puts back into the mask, so every batch ends with a 4-byte read
+    //     instead of a copy and a scan of the whole mask.  The batch size follows the counter, see AdaptiveBatch.
+    AdaptiveBatch batch;
+    int h_changedCount = 1;
+    while (h_changedCount > 0)
     {
-        // --- In order to improve performance, we run some number of iterations without reading the results.  This might result
-        //     in running more iterations than necessary at times, but it will in most cases be faster because we are doing less
-        //     stalling of the GPU waiting for results.
-        for (int asyncIter = 0; asyncIter < NUM_ASYNCHRONOUS_ITERATIONS; asyncIter++)
+        int iterations = batch.Size();
+        for (int asyncIter = 0; asyncIter < iterations; asyncIter++)
         {
             Kernel1<<<iDivUp(graph.vertex_array.size(), BLOCK_SIZE), BLOCK_SIZE >>>(d_vertexArray,
                                                                                     d_edgeArray,
@@ -154,7 +184,11 @@ std::vector<float> dijkstra_cuda(const Graph &graph, int sourceVertex)
                                                                                     graph.vertex_array.size(),
                                                                                     graph.edge_array.size());
             gpuErrchk(cudaPeekAtLastError());
-            gpuErrchk(cudaDeviceSynchronize());
+
+            if (asyncIter == iterations - 1)
+            {
+                gpuErrchk(cudaMemsetAsync(d_changedCount, 0, sizeof(int)));
+            }
 
             Kernel2<<<iDivUp(graph.vertex_array.size(), BLOCK_SIZE), BLOCK_SIZE >>>(d_vertexArray,
                                                                                     d_edgeArray,
@@ -162,26 +196,49 @@ std::vector<float> dijkstra_cuda(const Graph &graph, int sourceVertex)
                                                                                     d_finalizedVertices,
                                                                                     d_shortestDistances,
                                                                                     d_updatingShortestDistances,
-                                                                                    graph.vertex_array.size());
+                                                                                    graph.vertex_array.size(),
+                                                                                    d_changedCount);
             gpuErrchk(cudaPeekAtLastError());
-            gpuErrchk(cudaDeviceSynchronize());
         }
 
-        gpuErrchk(cudaMemcpy(h_finalizedVertices, d_finalizedVertices, sizeof(bool) * graph.vertex_array.size(), cudaMemcpyDeviceToHost));
+        // --- Every masked vertex was set by the last Kernel2, so zero means converged
+        gpuErrchk(cudaMemcpy(&h_changedCount, d_changedCount, sizeof(int), cudaMemcpyDeviceToHost));
+        batch.Update(h_changedCount);
     }
 
     // --- Copy the result to host
     std::vector<float> shortest_distance(graph.vertex_array.size());
     gpuErrchk(cudaMemcpy(shortest_distance.data(), d_shortestDistances, sizeof(float) * shortest_distance.size(), cudaMemcpyDeviceToHost));
 
+    // --- Shortest path tree, if requested
+    if (parents != nullptr)
+    {
+        parents->assign(graph.vertex_array.size(), DIJKSTRA_NO_PARENT);
+        (*parents)[sourceVertex] = sourceVertex;
+
+        int * d_parents; gpuErrchk(cudaMalloc(&d_parents, sizeof(int) * parents->size()));
+        gpuErrchk(cudaMemcpy(d_parents, parents->data(), sizeof(int) * parents->size(), cudaMemcpyHostToDevice));
+
+        computeParents<<<iDivUp(graph.vertex_array.size(), BLOCK_SIZE), BLOCK_SIZE >>>(d_vertexArray,
+                                                                                       d_edgeArray,
+                                                                                       d_weightArray,
+                                                                                       d_shortestDistances,
+                                                                                       d_parents,
+                                                                                       sourceVertex,
+                                                                                       graph.vertex_array.size(),
+                                                                                       graph.edge_array.size());
+        gpuErrchk(cudaPeekAtLastError());
+        gpuErrchk(cudaMemcpy(parents->data(), d_parents, sizeof(int) * parents->size(), cudaMemcpyDeviceToHost));
+        gpuErrchk(cudaFree(d_parents));
+    }
+
     gpuErrchk(cudaFree(d_vertexArray));
     gpuErrchk(cudaFree(d_edgeArray));
     gpuErrchk(cudaFree(d_weightArray));
     gpuErrchk(cudaFree(d_finalizedVertices));
     gpuErrchk(cudaFree(d_shortestDistances));
     gpuErrchk(cudaFree(d_updatingShortestDistances));
-
-    delete [] h_finalizedVertices;
+    gpuErrchk(cudaFree(d_changedCount));
 
     return shortest_distance;
 }
\ No newline at end of file
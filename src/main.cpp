@@ -1,66 +1,379 @@
 #include <iostream>
 #include <iomanip>
 #include <chrono>
-#include <fstream>
+#include <cstdlib>
+#include <sstream>
 
 
 #include <omp.h>
-#include "src/dijkstra.hpp"
+#include "src/benchmark.hpp"
+#include "src/server.hpp"
 
-void print_results(const std::string& msg, const std::vector<float> &res, int source_vertex)
+static void print_usage(const char *program, const std::vector<Backend> &backends,
+                        const std::vector<PointToPointEngine> &p2p_engines)
 {
-#if PRINT_RESULTS != 0
-    std::cout << std::endl << msg << std::endl;
-    for (auto k = 0ULL; k < res.size(); k++)
+    std::cout << "Usage: " << program << " [options]" << std::endl << std::endl
+              << "Graph selection:" << std::endl
+              << "  --sizes LIST           vertex counts, comma separated or start:stop:step (stop inclusive)" << std::endl
+              << "  --degrees LIST         neighbors per vertex (default: size / degree divisor)" << std::endl
+              << "  --degree-divisor N     default degree is size / N (default 128)" << std::endl
+              << "  --seeds LIST           generator seeds (default 0)" << std::endl
+              << "  --topology NAME        uniform, erdos-renyi, rmat or grid (default uniform)" << std::endl
+              << "  --input PATH           run on a graph file instead of generated graphs" << std::endl
+              << "  --format NAME          format of --input: dimacs, snap or snapshot (default snap)" << std::endl
+              << "  --snapshot-dir DIR     cache generated graphs in DIR as binary snapshots" << std::endl
+              << std::endl
+              << "Measurement:" << std::endl
+              << "  --backends LIST        backends to run (default: all available)" << std::endl
+              << "  --source N             source vertex (default 0)" << std::endl
+              << "  --warmup N             untimed runs per backend (default 0)" << std::endl
+              << "  --reps N               timed runs per backend (default 1)" << std::endl
+              << "  --parents              also compute the shortest path tree in the timed runs" << std::endl
+              << "  --reorder NAME         also time every backend on the graph renumbered by bfs, rcm or degree" << std::endl
+              << "  --delta X              delta-stepping bucket width (default: heuristic)" << std::endl
+              << "  --batch N              add the heap-batch backend: N queries per run through dijkstra_batch" << std::endl
+              << "  --validate[=NAME]      compare every backend with NAME (default sequential), fail on divergence" << std::endl
+              << "  --tolerance X          relative tolerance of the comparison (default 1e-5)" << std::endl
+              << "  --p2p N                time N random point-to-point queries per graph (instead of the SSSP" << std::endl
+              << "                         backends, unless --backends is given)" << std::endl
+              << "  --p2p-engines LIST     point-to-point engines to run (default: all)" << std::endl
+              << "  --landmarks N          landmarks of the alt engine (default 16)" << std::endl
+              << "  --alt-backend NAME     backend that computes the landmark distance tables (default delta)" << std::endl
+              << "  --dynamic LIST         time incremental repair after batches of LIST random edge-weight" << std::endl
+              << "                         changes against a full run (--reps batches per size; replaces the SSSP" << std::endl
+              << "                         backends like --p2p)" << std::endl
+              << std::endl
+              << "Server:" << std::endl
+              << "  --serve PATH           keep the graph resident and answer queries on the Unix socket PATH" << std::endl
+              << "                         (- for a line protocol on stdin/stdout, see src/server.hpp)" << std::endl
+              << "  --serve-backend NAME   backend of the single-source queries (default heap)" << std::endl
+              << "  --serve-p2p NAME       engine of the point-to-point queries (default bidirectional)" << std::endl
+              << "  --cache-mib N          budget of the per-source distance cache (default 256)" << std::endl
+              << "  --connect PATH         send the lines of stdin to a server and print the replies" << std::endl
+              << std::endl
+              << "Output:" << std::endl
+              << "  --csv PATH             CSV results (default output.csv, empty to disable)" << std::endl
+              << "  --json PATH            JSON results with every sample" << std::endl
+              << std::endl
+              << "Available backends:" << std::endl;
+    for (const auto &backend : backends)
     {
-        std::cout << "From vertex " << source_vertex << " to vertex " << k << " = " << res[k] << std::endl;
+        std::cout << "  " << std::left << std::setw(16) << backend.name << " " << backend.description << std::endl;
+    }
+    std::cout << std::endl << "Point-to-point engines:" << std::endl;
+    for (const auto &engine : p2p_engines)
+    {
+        std::cout << "  " << std::left << std::setw(16) << engine.name << " " << engine.description << std::endl;
     }
-#else
-    (void)msg;
-    (void)res;
-    (void)source_vertex;
-#endif
 }
 
-void print_duration(const std::string& name, std::chrono::time_point<std::chrono::high_resolution_clock> start,
-                    std::chrono::time_point<std::chrono::high_resolution_clock> finish,
-                    std::ofstream &output_file)
+static std::vector<std::string> split(const std::string &value, char separator)
 {
-    std::chrono::duration<double> elapsed = finish - start;
-    std::cout << std::fixed << std::setw( 11 ) << std::setprecision( 6 ) << "Duration of " << name << " algorithm: " << elapsed.count() << " seconds" << std::endl;
+    std::vector<std::string> parts;
+    std::istringstream stream(value);
+    std::string part;
+    while (std::getline(stream, part, separator))
+    {
+        if (!part.empty())
+        {
+            parts.push_back(part);
+        }
+    }
+    return parts;
+}
+
+static bool parse_number(const std::string &value, long long &number)
+{
+    char *end = nullptr;
+    number = std::strtoll(value.c_str(), &end, 10);
+    return !value.empty() && *end == '\0';
+}
+
+// Either "a,b,c" or "start:stop:step" with an inclusive stop
+static bool parse_int_list(const std::string &value, std::vector<int> &list)
+{
+    list.clear();
+
+    auto range = split(value, ':');
+    if (range.size() == 3)
+    {
+        long long first, last, step;
+        if (!parse_number(range[0], first) || !parse_number(range[1], last) || !parse_number(range[2], step) || step <= 0)
+        {
+            return false;
+        }
+        for (auto i = first; i <= last; i += step)
+        {
+            list.push_back(static_cast<int>(i));
+        }
+        return !list.empty();
+    }
 
-    if (output_file.good())
+    for (const auto &item : split(value, ','))
     {
-        output_file << std::fixed << std::setw( 11 ) << std::setprecision( 6 ) << " " << elapsed.count();
+        long long number;
+        if (!parse_number(item, number) || number <= 0)
+        {
+            return false;
+        }
+        list.push_back(static_cast<int>(number));
     }
+    return !list.empty();
 }
 
-int main() {
+int main(int argc, char *argv[]) {
 
-    // --- Number of graph vertices
+    // --- Largest graph of the default sweep
 #ifdef TOTAL_VERTICES
     int num_vertices = TOTAL_VERTICES;
 #else
     int num_vertices = 1024 * 20;
 #endif
-    // --- Number of edges per graph vertex
+    // --- The default sweep generates size / MAX_NEIGHBOUR_VERTICES neighbors per vertex
 #ifdef MAX_NEIGHBOUR_VERTICES
-    int neighbors_per_vertex = MAX_NEIGHBOUR_VERTICES;
+    int degree_divisor = MAX_NEIGHBOUR_VERTICES;
 #else
-    int neighbors_per_vertex = 128;
+    int degree_divisor = 128;
 #endif
-    // --- Source vertex
-    int sourceVertex = 0;
 
-    std::chrono::time_point<std::chrono::high_resolution_clock> start;
-    std::chrono::time_point<std::chrono::high_resolution_clock> finish;
+    BenchmarkOptions options;
+    options.degree_divisor = degree_divisor;
+    options.seeds.push_back(0);
+    options.topology = GRAPH_TOPOLOGY_UNIFORM;
+    options.input_format = "snap";
+    options.source_vertex = 0;
+    options.warmup = 0;
+    options.repetitions = 1;
+    options.parents = false;
+    options.reorder = false;
+    options.ordering = GRAPH_ORDERING_RCM;
+    options.p2p_queries = 0;
+    options.csv_path = "output.csv";
+    options.validate = false;
+    options.reference = "sequential";
+    options.tolerance = 1e-5f;
+
+    BackendConfig config;
+    config.cpu_found = config.gpu_found = false;
+    config.delta = 0.f;
+    config.batch_sources = 0;
+    config.alt_landmarks = 16;
+    config.alt_backend = "delta";
+
+    ServerOptions server;
+    server.backend = "heap";
+    server.p2p_engine = "bidirectional";
+    server.cache_bytes = 256ULL << 20;
+    server.reply_fd = -1;
+    std::string connect_path;
+
+    bool show_help = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h")
+        {
+            show_help = true;
+            continue;
+        }
+        if (arg == "--parents")
+        {
+            options.parents = true;
+            continue;
+        }
+        if (arg == "--validate" || arg.compare(0, 11, "--validate=") == 0)
+        {
+            options.validate = true;
+            if (arg.size() > 11)
+            {
+                options.reference = arg.substr(11);
+            }
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 1;
+        }
+
+        std::string value = argv[++i];
+        long long number = 0;
+        bool valid = true;
+
+        if (arg == "--backends")
+        {
+            options.backends = split(value, ',');
+        }
+        else if (arg == "--sizes")
+        {
+            valid = parse_int_list(value, options.sizes);
+        }
+        else if (arg == "--degrees")
+        {
+            valid = parse_int_list(value, options.degrees);
+        }
+        else if (arg == "--degree-divisor")
+        {
+            valid = parse_number(value, number) && number > 0;
+            options.degree_divisor = static_cast<int>(number);
+        }
+        else if (arg == "--seeds")
+        {
+            options.seeds.clear();
+            for (const auto &item : split(value, ','))
+            {
+                valid = valid && parse_number(item, number) && number >= 0;
+                options.seeds.push_back(static_cast<uint64_t>(number));
+            }
+            valid = valid && !options.seeds.empty();
+        }
+        else if (arg == "--topology")
+        {
+            valid = parse_topology(value, options.topology);
+        }
+        else if (arg == "--reorder")
+        {
+            options.reorder = true;
+            valid = parse_ordering(value, options.ordering);
+        }
+        else if (arg == "--input")
+        {
+            options.input_path = value;
+        }
+        else if (arg == "--format")
+        {
+            options.input_format = value;
+            valid = value == "dimacs" || value == "snap" || value == "snapshot";
+        }
+        else if (arg == "--snapshot-dir")
+        {
+            options.snapshot_dir = value;
+        }
+        else if (arg == "--source")
+        {
+            valid = parse_number(value, number) && number >= 0;
+            options.source_vertex = static_cast<int>(number);
+        }
+        else if (arg == "--warmup")
+        {
+            valid = parse_number(value, number) && number >= 0;
+            options.warmup = static_cast<int>(number);
+        }
+        else if (arg == "--reps")
+        {
+            valid = parse_number(value, number) && number > 0;
+            options.repetitions = static_cast<int>(number);
+        }
+        else if (arg == "--delta")
+        {
+            config.delta = std::strtof(value.c_str(), nullptr);
+            valid = config.delta > 0.f;
+        }
+        else if (arg == "--tolerance")
+        {
+            options.tolerance = std::strtof(value.c_str(), nullptr);
+            valid = options.tolerance >= 0.f;
+        }
+        else if (arg == "--batch")
+        {
+            valid = parse_number(value, number) && number > 0;
+            config.batch_sources = static_cast<int>(number);
+        }
+        else if (arg == "--p2p")
+        {
+            valid = parse_number(value, number) && number >= 0;
+            options.p2p_queries = static_cast<int>(number);
+        }
+        else if (arg == "--landmarks")
+        {
+            valid = parse_number(value, number) && number > 0;
+            config.alt_landmarks = static_cast<int>(number);
+        }
+        else if (arg == "--alt-backend")
+        {
+            config.alt_backend = value;
+        }
+        else if (arg == "--p2p-engines")
+        {
+            options.p2p_engines = split(value, ',');
+        }
+        else if (arg == "--dynamic")
+        {
+            valid = parse_int_list(value, options.dynamic_batches);
+        }
+        else if (arg == "--serve")
+        {
+            server.socket_path = value;
+        }
+        else if (arg == "--serve-backend")
+        {
+            server.backend = value;
+        }
+        else if (arg == "--serve-p2p")
+        {
+            server.p2p_engine = value;
+        }
+        else if (arg == "--cache-mib")
+        {
+            valid = parse_number(value, number) && number >= 0;
+            server.cache_bytes = static_cast<size_t>(number) << 20;
+        }
+        else if (arg == "--connect")
+        {
+            connect_path = value;
+        }
+        else if (arg == "--csv")
+        {
+            options.csv_path = value;
+        }
+        else if (arg == "--json")
+        {
+            options.json_path = value;
+        }
+        else
+        {
+            std::cerr << "Unknown option " << arg << ", see --help" << std::endl;
+            return 1;
+        }
+
+        if (!valid)
+        {
+            std::cerr << "Invalid value for " << arg << ": " << value << std::endl;
+            return 1;
+        }
+    }
+
+    if (options.sizes.empty())
+    {
+        for (int i = 1024; i < num_vertices; i += 1024)
+        {
+            options.sizes.push_back(i);
+        }
+    }
+
+    if (show_help)
+    {
+        auto backends = available_backends(config);
+        print_usage(argv[0], backends, available_point_to_point_engines(config, backends));
+        return 0;
+    }
 
-    std::ofstream out_file("output.dat");
+    if (!connect_path.empty())
+    {
+        return run_client(connect_path);
+    }
 
-    std::cout << std::fixed << std::setw( 11 ) << std::setprecision( 6 ) << "Dijkstra's algorithm test, " << num_vertices << " vertices, " << neighbors_per_vertex << " neighbors per vertex" << std::endl;
-    cl_context gpu_context, cpu_context;
-    bool gpu_found = false, cpu_found = false;
-    auto init_res = dijkstra_init_contexts(gpu_context, cpu_context);
+    // Serving on stdin/stdout, from here on stdout is reserved for the replies
+    if (server.socket_path == "-")
+    {
+        server.reply_fd = reserve_stdout_for_replies();
+        if (server.reply_fd < 0)
+        {
+            return 1;
+        }
+    }
+
+    auto init_res = dijkstra_init_contexts(config.gpu_context, config.cpu_context);
 
     switch (init_res)
     {
@@ -71,15 +384,15 @@ int main() {
             std::cerr << "No OpenCL platform found" << std::endl;
 	    break;
         case OCL_INIT_CPU_ONLY:
-            cpu_found = true;
+            config.cpu_found = true;
             std::cerr << "Suitable GPU for OpenCL was not found on the system" << std::endl;
             break;
         case OCL_INIT_GPU_ONLY:
-            gpu_found = true;
+            config.gpu_found = true;
             std::cerr << "Suitable CPU for OpenCL was not found on the system" << std::endl;
             break;
         case OCL_INIT_SUCCESS:
-            gpu_found = cpu_found = true;
+            config.gpu_found = config.cpu_found = true;
             break;
     }
 
@@ -87,87 +400,19 @@ int main() {
     acc_init(acc_device_nvidia);
 #endif
 
-#if 0
-      // --- Allocate memory for arrays
-    std::cout << "Generating graph...";
-    std::cout.flush();
-    Graph graph(num_vertices, neighbors_per_vertex);
-    std::cout << "\tDone" << std::endl;
-#endif
-
-    // --- Displaying the adjacency list and constructing the adjacency matrix
-    #if PRINT_GRAPH_DATA != 0
-        graph.PrintVertexData();
-        graph.DisplayWeightMatrix();
-    #endif
-
-    for (int i = 1024; i < num_vertices; i += 1024)
+    auto backends = available_backends(config);
+    if (!server.socket_path.empty())
     {
-        std::cout << "Generating graph with " << i << " vertices and " << i / neighbors_per_vertex << " neighbors per vertex...";
-        std::cout.flush();
-        Graph graph(i, i / neighbors_per_vertex);
-        std::cout << "\tDone" << std::endl;
-
-        out_file << i;
-
-        // --- Running sequential Dijkstra on the CPU
-        start = std::chrono::high_resolution_clock::now();
-        auto shortest_distances_seq = dijkstra_sequential(graph, sourceVertex);
-        finish = std::chrono::high_resolution_clock::now();
-        print_results("CPU results", shortest_distances_seq, sourceVertex);
-        print_duration("CPU", start, finish, out_file);
-        shortest_distances_seq.clear();
-
-        // --- Running parallel Dijkstra on the CPU with OMP
-        start = std::chrono::high_resolution_clock::now();
-        auto shortest_distances_omp = dijkstra_omp(graph, sourceVertex);
-        finish = std::chrono::high_resolution_clock::now();
-        print_results("CPU results (OpenMP)", shortest_distances_omp, sourceVertex);
-        print_duration("CPU (OpenMP)", start, finish, out_file);
-        shortest_distances_omp.clear();
-
-        // --- Running parallel Dijkstra on the CPU with OpenCL
-        if (cpu_found)
-        {
-            start = std::chrono::high_resolution_clock::now();
-            auto shortest_distances_ocl_cpu = dijkstra_opencl(graph, sourceVertex, cpu_context);
-            finish = std::chrono::high_resolution_clock::now();
-            print_results("CPU results (OpenCL)", shortest_distances_ocl_cpu, sourceVertex);
-            print_duration("CPU (OpenCL)", start, finish, out_file);
-            shortest_distances_ocl_cpu.clear();
-        }
-
-        // --- Running parallel Dijkstra on the GPU with OpenCL
-        if (gpu_found)
-        {
-            start = std::chrono::high_resolution_clock::now();
-            auto shortest_distances_ocl_gpu = dijkstra_opencl(graph, sourceVertex, gpu_context);
-            finish = std::chrono::high_resolution_clock::now();
-            print_results("GPU results (OpenCL)", shortest_distances_ocl_gpu, sourceVertex);
-            print_duration("GPU (OpenCL)", start, finish, out_file);
-            shortest_distances_ocl_gpu.clear();
-        }
-
-    #if ENABLE_CUDA == 1
-        std::chrono::high_resolution_clock::now();
-        auto shortest_distances_cuda_gpu = dijkstra_cuda(graph, sourceVertex);
-        finish = std::chrono::high_resolution_clock::now();
-        print_results("GPU results (CUDA)", shortest_distances_cuda_gpu, sourceVertex);
-        print_duration("GPU (CUDA)", start, finish, out_file);
-        shortest_distances_cuda_gpu.clear();
-    #endif
-
-    #if 1
-        std::chrono::high_resolution_clock::now();
-        auto shortest_distances_openacc_gpu = dijkstra_acc(graph, sourceVertex);
-        finish = std::chrono::high_resolution_clock::now();
-        print_results("GPU results (OpenACC)", shortest_distances_openacc_gpu, sourceVertex);
-        print_duration("GPU (OpenACC)", start, finish, out_file);
-        shortest_distances_openacc_gpu.clear();
-    #endif
-
-        out_file << std::endl;
+        auto start = std::chrono::high_resolution_clock::now();
+        Graph graph = load_graph(options);
+        if (graph.vertex_array.empty())
+        {
+            std::cerr << "No graph to serve" << std::endl;
+            return 1;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+        std::cerr << "Graph loaded in " << elapsed.count() << " s" << std::endl;
+        return run_server(server, graph, backends, available_point_to_point_engines(config, backends));
     }
-
-    return 0;
+    return run_benchmark(options, backends, available_point_to_point_engines(config, backends));
 }
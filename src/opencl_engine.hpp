@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "src/dijkstra.hpp"
+
+///
+/// Long-lived OpenCL state for one context.
+///
+/// The device, command queue, program and kernels are created once.  The
+/// compiled program is cached on disk (CL_PROGRAM_BINARIES) next to the kernel
+/// source, keyed by the source text and the device/driver, so only the first
+/// run on a machine pays for clBuildProgram.  The graph stays resident on the
+/// device between queries and is only uploaded again when a graph with a
+/// different Graph::Revision() comes in.
+///
+/// An engine is not thread-safe; dijkstra_opencl keeps one per context.
+///
+class OpenCLEngine
+{
+public:
+    explicit OpenCLEngine(cl_context context, const std::string &kernel_path = "dijkstra.cl");
+    ~OpenCLEngine();
+
+    OpenCLEngine(const OpenCLEngine &) = delete;
+    OpenCLEngine &operator=(const OpenCLEngine &) = delete;
+
+    // False if the program could not be built, Run then returns an empty vector
+    bool IsReady() const { return this->program != nullptr; }
+    // True if the program came from the binary cache instead of the compiler
+    bool LoadedFromCache() const { return this->from_cache; }
+
+    // Harish-Narayanan kernels: one work-item per vertex every iteration
+    std::vector<float> Run(const Graph &graph, int source_vertex, std::vector<int> *parents = nullptr);
+
+    // Frontier-compacted kernels: every iteration relaxes only the vertices
+    // whose cost went down in the previous one
+    std::vector<float> RunFrontier(const Graph &graph, int source_vertex, std::vector<int> *parents = nullptr);
+
+private:
+    cl_context context;
+    cl_device_id device;
+    cl_command_queue queue;
+    cl_program program;
+    bool from_cache;
+    size_t max_work_group_size;
+
+    cl_kernel initialize_kernel;
+    cl_kernel sssp_kernel1;
+    cl_kernel sssp_kernel2;
+    cl_kernel parents_kernel;
+    cl_kernel frontier_init_kernel;
+    cl_kernel frontier_relax_kernel;
+
+    // --- Resident graph and the per-query buffers sized for it
+    uint64_t graph_revision;
+    int vertex_count;
+    int edge_count;
+    size_t global_work_size;
+
+    cl_mem vertex_array;
+    cl_mem edge_array;
+    cl_mem weight_array;
+    cl_mem mask_array;
+    cl_mem cost_array;
+    cl_mem updating_cost_array;
+    cl_mem parent_array;
+    cl_mem queued_array;
+    cl_mem frontiers[2];
+    cl_mem frontier_size;
+
+    void upload_graph(const Graph &graph);
+    void release_graph();
+    bool prepare(const Graph &graph);
+    void read_results(int source_vertex, std::vector<float> &costs, std::vector<int> *parents);
+};
+
+// The engine dijkstra_opencl uses for `context`, created on the first call
+OpenCLEngine &opencl_engine(cl_context context);
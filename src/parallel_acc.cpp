@@ -5,7 +5,7 @@
 
 #define NUM_ASYNCHRONOUS_ITERATIONS 20  // Number of async loop iterations before attempting to read results back
 
-std::vector<float> dijkstra_acc(const Graph &graph, int source_vertex)
+std::vector<float> dijkstra_acc(const Graph &graph, int source_vertex, std::vector<int> *parents)
 {
     auto number_of_vetecies = graph.vertex_array.size();
 
@@ -28,8 +28,8 @@ std::vector<float> dijkstra_acc(const Graph &graph, int source_vertex)
     distances[source_vertex] = 0.f;
     updating_distances[source_vertex] = 0.f;
 
-    // --- Dijkstra iterations
-    while (!std::all_of(finalized_verticies.cbegin(), finalized_verticies.cend(), [](bool i){ return i == false; }))
+    // --- Dijkstra iterations, as long as any vertex is masked
+    while (std::any_of(finalized_verticies.cbegin(), finalized_verticies.cend(), [](bool i){ return i; }))
     {
         for (int asyncIter = 0; asyncIter < NUM_ASYNCHRONOUS_ITERATIONS; asyncIter++)
         {
@@ -77,5 +77,10 @@ std::vector<float> dijkstra_acc(const Graph &graph, int source_vertex)
             }
         }
     }
+
+    if (parents != nullptr)
+    {
+        dijkstra_parents_from_distances(graph, source_vertex, distances, *parents);
+    }
     return distances;
 }
\ No newline at end of file
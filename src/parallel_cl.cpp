@@ -6,8 +6,15 @@
 #include <sstream>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <map>
+#include <memory>
 
-#include "src/dijkstra.hpp"
+#include "src/opencl_engine.hpp"
+#include "src/adaptive_batch.hpp"
+#include "common/random.hpp"
 
 
 ///
@@ -20,16 +27,9 @@ pthread_mutex_t mtx = PTHREAD_MUTEX_INITIALIZER;
 //
 #define check_error(a, b) assert_msg(a, b, __FILE__ , __LINE__)
 
-///
-//  Macro Options
-//
-#define NUM_ASYNCHRONOUS_ITERATIONS 20  // Number of async loop iterations before attempting to read results back
-
 ///
 //  Function prototypes
 //
-bool maskArrayEmpty(int *maskArray, int count);
-
 cl_device_id get_first_device(cl_context cxGPUContext);
 
 static inline void assert_msg(int errNum, int expected, const char* file, const int lineNumber);
@@ -124,10 +124,98 @@ void print_device_info()
     free(platforms);
 }
 
-static cl_program load_and_build_program(cl_context opencl_context, const char *fileName)
+///
+/// Name of the binary cache file for `source` built on `device`: the kernel
+/// path plus a hash of everything the binary depends on
+///
+static std::string binary_cache_path(const char *fileName, const std::string &source, cl_device_id device)
 {
-    pthread_mutex_lock(&mtx);
+    std::string key = source;
+    const cl_device_info infos[] = { CL_DEVICE_NAME, CL_DEVICE_VENDOR, CL_DRIVER_VERSION, CL_DEVICE_VERSION };
+    for (auto info : infos)
+    {
+        size_t size = 0;
+        clGetDeviceInfo(device, info, 0, NULL, &size);
+        std::vector<char> value(size + 1, '\0');
+        clGetDeviceInfo(device, info, size, value.data(), NULL);
+        key += '\n';
+        key += value.data();
+    }
+
+    uint64_t hash = 0;
+    for (auto c : key)
+    {
+        hash = CounterRng::mix(hash ^ static_cast<unsigned char>(c));
+    }
 
+    std::ostringstream path;
+    path << fileName << "." << std::hex << hash << ".bin";
+    return path.str();
+}
+
+static cl_program build_from_binary(cl_context opencl_context, cl_device_id device, const std::string &cachePath)
+{
+    std::ifstream cacheFile(cachePath, std::ios::in | std::ios::binary);
+    if (!cacheFile.is_open())
+    {
+        return NULL;
+    }
+
+    std::vector<unsigned char> binary((std::istreambuf_iterator<char>(cacheFile)), std::istreambuf_iterator<char>());
+    const unsigned char *binaryData = binary.data();
+    size_t binarySize = binary.size();
+
+    cl_int errNum, binaryStatus;
+    cl_program program = clCreateProgramWithBinary(opencl_context, 1, &device, &binarySize, &binaryData,
+                                                   &binaryStatus, &errNum);
+    if (errNum != CL_SUCCESS || binaryStatus != CL_SUCCESS)
+    {
+        if (program != NULL)
+        {
+            clReleaseProgram(program);
+        }
+        return NULL;
+    }
+
+    // A stale or foreign binary is not an error, the caller falls back to the source
+    if (clBuildProgram(program, 1, &device, NULL, NULL, NULL) != CL_SUCCESS)
+    {
+        clReleaseProgram(program);
+        return NULL;
+    }
+    return program;
+}
+
+static void save_binary(cl_program program, const std::string &cachePath)
+{
+    size_t binarySize = 0;
+    if (clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(binarySize), &binarySize, NULL) != CL_SUCCESS ||
+        binarySize == 0)
+    {
+        return;
+    }
+
+    std::vector<unsigned char> binary(binarySize);
+    unsigned char *binaryData = binary.data();
+    if (clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(binaryData), &binaryData, NULL) != CL_SUCCESS)
+    {
+        return;
+    }
+
+    // Write to a temporary file and rename it, so that concurrent runs never
+    // see a partially written binary
+    auto temporaryPath = cachePath + ".tmp";
+    std::ofstream cacheFile(temporaryPath, std::ios::out | std::ios::binary);
+    cacheFile.write(reinterpret_cast<const char *>(binary.data()), binary.size());
+    cacheFile.close();
+    if (!cacheFile || std::rename(temporaryPath.c_str(), cachePath.c_str()) != 0)
+    {
+        std::remove(temporaryPath.c_str());
+    }
+}
+
+static cl_program build_program(cl_context opencl_context, cl_device_id device, const char *fileName, bool &fromCache)
+{
     cl_int errNum;
     cl_program program;
 
@@ -145,93 +233,46 @@ static cl_program load_and_build_program(cl_context opencl_context, const char *
     std::string srcStdStr = oss.str();
     const char *source = srcStdStr.c_str();
 
-    check_error(source != NULL, true);
+    auto cachePath = binary_cache_path(fileName, srcStdStr, device);
+    program = build_from_binary(opencl_context, device, cachePath);
+    fromCache = program != NULL;
+    if (fromCache)
+    {
+        return program;
+    }
 
-    // Create the program for all GPUs in the context
+    // Create and build the program for the device the engine runs on
     program = clCreateProgramWithSource(opencl_context, 1, (const char **)&source, NULL, &errNum);
     check_error(errNum, CL_SUCCESS);
-    // build the program for all devices on the context
-    errNum = clBuildProgram(program, 0, NULL, NULL, NULL, NULL);
+    errNum = clBuildProgram(program, 1, &device, NULL, NULL, NULL);
     if (errNum != CL_SUCCESS)
     {
         char cBuildLog[10240];
-        clGetProgramBuildInfo(program, get_first_device(opencl_context), CL_PROGRAM_BUILD_LOG,
-                              sizeof(cBuildLog), cBuildLog, NULL );
+        clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, sizeof(cBuildLog), cBuildLog, NULL);
 
         std::cerr << cBuildLog << std::endl;
-        check_error(errNum, CL_SUCCESS);
+        clReleaseProgram(program);
+        return NULL;
     }
 
-    pthread_mutex_unlock(&mtx);
+    save_binary(program, cachePath);
     return program;
 }
 
-static void allocate_ocl_buffers(cl_context gpuContext, cl_command_queue commandQueue, const Graph &graph,
-                                 cl_mem *vertexArrayDevice, cl_mem *edgeArrayDevice, cl_mem *weightArrayDevice,
-                                 cl_mem *maskArrayDevice, cl_mem *costArrayDevice, cl_mem *updatingCostArrayDevice,
-                                 size_t globalWorkSize)
-{
-    cl_int errNum;
-    cl_mem hostVertexArrayBuffer;
-    cl_mem hostEdgeArrayBuffer;
-    cl_mem hostWeightArrayBuffer;
-
-    // First, need to create OpenCL Host buffers that can be copied to device buffers
-    hostVertexArrayBuffer = clCreateBuffer(gpuContext, CL_MEM_COPY_HOST_PTR | CL_MEM_ALLOC_HOST_PTR,
-                                           sizeof(int) * graph.vertex_array.size(), (void *)graph.vertex_array.data(), &errNum);
-    check_error(errNum, CL_SUCCESS);
-
-    hostEdgeArrayBuffer = clCreateBuffer(gpuContext, CL_MEM_COPY_HOST_PTR | CL_MEM_ALLOC_HOST_PTR,
-                                           sizeof(int) * graph.edge_array.size(), (void *)graph.edge_array.data(), &errNum);
-    check_error(errNum, CL_SUCCESS);
-
-    hostWeightArrayBuffer = clCreateBuffer(gpuContext, CL_MEM_COPY_HOST_PTR | CL_MEM_ALLOC_HOST_PTR,
-                                           sizeof(float) * graph.edge_array.size(), (void *)graph.weight_array.data(), &errNum);
-    check_error(errNum, CL_SUCCESS);
-
-    // Now create all of the GPU buffers
-    *vertexArrayDevice = clCreateBuffer(gpuContext, CL_MEM_READ_ONLY, sizeof(int) * globalWorkSize, NULL, &errNum);
-    check_error(errNum, CL_SUCCESS);
-    *edgeArrayDevice = clCreateBuffer(gpuContext, CL_MEM_READ_ONLY, sizeof(int) * graph.edge_array.size(), NULL, &errNum);
-    check_error(errNum, CL_SUCCESS);
-    *weightArrayDevice = clCreateBuffer(gpuContext, CL_MEM_READ_ONLY, sizeof(float) * graph.edge_array.size(), NULL, &errNum);
-    check_error(errNum, CL_SUCCESS);
-    *maskArrayDevice = clCreateBuffer(gpuContext, CL_MEM_READ_WRITE, sizeof(int) * globalWorkSize, NULL, &errNum);
-    check_error(errNum, CL_SUCCESS);
-    *costArrayDevice = clCreateBuffer(gpuContext, CL_MEM_READ_WRITE, sizeof(float) * globalWorkSize, NULL, &errNum);
-    check_error(errNum, CL_SUCCESS);
-    *updatingCostArrayDevice = clCreateBuffer(gpuContext, CL_MEM_READ_WRITE, sizeof(float) * globalWorkSize, NULL, &errNum);
-    check_error(errNum, CL_SUCCESS);
-
-    // Now queue up the data to be copied to the device
-    errNum = clEnqueueCopyBuffer(commandQueue, hostVertexArrayBuffer, *vertexArrayDevice, 0, 0,
-                                 sizeof(int) * graph.vertex_array.size(), 0, NULL, NULL);
-    check_error(errNum, CL_SUCCESS);
-
-    errNum = clEnqueueCopyBuffer(commandQueue, hostEdgeArrayBuffer, *edgeArrayDevice, 0, 0,
-                                 sizeof(int) * graph.edge_array.size(), 0, NULL, NULL);
-    check_error(errNum, CL_SUCCESS);
-
-    errNum = clEnqueueCopyBuffer(commandQueue, hostWeightArrayBuffer, *weightArrayDevice, 0, 0,
-                                 sizeof(float) * graph.edge_array.size(), 0, NULL, NULL);
-    check_error(errNum, CL_SUCCESS);
-
-    clReleaseMemObject(hostVertexArrayBuffer);
-    clReleaseMemObject(hostEdgeArrayBuffer);
-    clReleaseMemObject(hostWeightArrayBuffer);
-}
-
-static void init_ocl_buffers(cl_command_queue commandQueue, cl_kernel initializeKernel, const Graph &graph,
-                            size_t maxWorkGroupSize)
+///
+/// Load the program from the binary cache or build it from `fileName`.  Builds
+/// are serialized, which also keeps concurrent engines from writing the same
+/// cache file; the lock is taken around build_program so every return path
+/// releases it.
+///
+static cl_program load_and_build_program(cl_context opencl_context, cl_device_id device, const char *fileName,
+                                         bool &fromCache)
 {
-    cl_int errNum;
-    // Set # of work items in work group and total in 1 dimensional range
-    size_t globalWorkSize [] = { 0 };
-    globalWorkSize[0] = roundWorkSizeUp(maxWorkGroupSize, graph.vertex_array.size());
+    pthread_mutex_lock(&mtx);
+    cl_program program = build_program(opencl_context, device, fileName, fromCache);
+    pthread_mutex_unlock(&mtx);
 
-    errNum = clEnqueueNDRangeKernel(commandQueue, initializeKernel, 1, NULL, globalWorkSize, NULL,
-                                    0, NULL, NULL);
-    check_error(errNum, CL_SUCCESS);
+    return program;
 }
 
 cl_device_id get_first_device(cl_context cxGPUContext)
@@ -332,171 +373,351 @@ int roundWorkSizeUp(int groupSize, int globalSize)
     }
 }
 
-static std::vector<float> run_dijkstra(cl_context context, cl_device_id deviceId, const Graph &graph, int source_vertex)
+OpenCLEngine::OpenCLEngine(cl_context context, const std::string &kernel_path) :
+    context(context), device(get_max_flops_dev(context)), queue(NULL), program(NULL), from_cache(false),
+    max_work_group_size(0), initialize_kernel(NULL), sssp_kernel1(NULL), sssp_kernel2(NULL), parents_kernel(NULL),
+    frontier_init_kernel(NULL), frontier_relax_kernel(NULL),
+    graph_revision(0), vertex_count(0), edge_count(0), global_work_size(0),
+    vertex_array(NULL), edge_array(NULL), weight_array(NULL), mask_array(NULL), cost_array(NULL),
+    updating_cost_array(NULL), parent_array(NULL), queued_array(NULL), frontiers{NULL, NULL}, frontier_size(NULL)
 {
-    // Create command queue
     cl_int errNum;
-    cl_command_queue commandQueue;
-
-    commandQueue = clCreateCommandQueue( context, deviceId, 0, &errNum );
-    check_error(errNum, CL_SUCCESS);
 
-    std::vector<float> shortest_path(graph.vertex_array.size(), 0);
-    cl_program program = load_and_build_program(context, "dijkstra.cl");
-    if (program == nullptr)
+    this->program = load_and_build_program(context, this->device, kernel_path.c_str(), this->from_cache);
+    if (this->program == NULL)
     {
-        return std::vector<float>();
+        return;
     }
 
-    // Get the max workgroup size
-    size_t maxWorkGroupSize = 0;
-    clGetDeviceInfo(deviceId, CL_DEVICE_MAX_WORK_GROUP_SIZE,
-                    sizeof(maxWorkGroupSize), &maxWorkGroupSize, NULL);
+    this->queue = clCreateCommandQueue(context, this->device, 0, &errNum);
+    check_error(errNum, CL_SUCCESS);
 
+    clGetDeviceInfo(this->device, CL_DEVICE_MAX_WORK_GROUP_SIZE,
+                    sizeof(this->max_work_group_size), &this->max_work_group_size, NULL);
 
-    // Set # of work items in work group and total in 1 dimensional range
-    size_t globalWorkSize = roundWorkSizeUp(maxWorkGroupSize, graph.vertex_array.size());
+    // Create the Kernels, the arguments are bound when a graph is uploaded
+    this->initialize_kernel = clCreateKernel(this->program, "initializeBuffers", &errNum);
+    check_error(errNum, CL_SUCCESS);
+    this->sssp_kernel1 = clCreateKernel(this->program, "OCL_SSSP_KERNEL1", &errNum);
+    check_error(errNum, CL_SUCCESS);
+    this->sssp_kernel2 = clCreateKernel(this->program, "OCL_SSSP_KERNEL2", &errNum);
+    check_error(errNum, CL_SUCCESS);
+    this->parents_kernel = clCreateKernel(this->program, "OCL_SSSP_PARENTS", &errNum);
+    check_error(errNum, CL_SUCCESS);
+    this->frontier_init_kernel = clCreateKernel(this->program, "OCL_FRONTIER_INIT", &errNum);
+    check_error(errNum, CL_SUCCESS);
+    this->frontier_relax_kernel = clCreateKernel(this->program, "OCL_FRONTIER_RELAX", &errNum);
+    check_error(errNum, CL_SUCCESS);
+}
 
-    cl_mem vertexArrayDevice;
-    cl_mem edgeArrayDevice;
-    cl_mem weightArrayDevice;
-    cl_mem maskArrayDevice;
-    cl_mem costArrayDevice;
-    cl_mem updatingCostArrayDevice;
+OpenCLEngine::~OpenCLEngine()
+{
+    this->release_graph();
 
-    // Allocate buffers in Device memory
-    allocate_ocl_buffers(context, commandQueue, graph, &vertexArrayDevice, &edgeArrayDevice, &weightArrayDevice,
-                         &maskArrayDevice, &costArrayDevice, &updatingCostArrayDevice, globalWorkSize);
+    if (this->program != NULL)
+    {
+        clReleaseKernel(this->initialize_kernel);
+        clReleaseKernel(this->sssp_kernel1);
+        clReleaseKernel(this->sssp_kernel2);
+        clReleaseKernel(this->parents_kernel);
+        clReleaseKernel(this->frontier_init_kernel);
+        clReleaseKernel(this->frontier_relax_kernel);
+        clReleaseCommandQueue(this->queue);
+        clReleaseProgram(this->program);
+    }
+}
 
+void OpenCLEngine::release_graph()
+{
+    cl_mem *buffers[] = { &this->vertex_array, &this->edge_array, &this->weight_array, &this->mask_array,
+                          &this->cost_array, &this->updating_cost_array, &this->parent_array, &this->queued_array,
+                          &this->frontiers[0], &this->frontiers[1], &this->frontier_size };
+    for (auto buffer : buffers)
+    {
+        if (*buffer != NULL)
+        {
+            clReleaseMemObject(*buffer);
+            *buffer = NULL;
+        }
+    }
+    this->graph_revision = 0;
+}
 
-    // Create the Kernels
-    cl_kernel initializeBuffersKernel;
-    initializeBuffersKernel = clCreateKernel(program, "initializeBuffers", &errNum);
-    check_error(errNum, CL_SUCCESS);
+void OpenCLEngine::upload_graph(const Graph &graph)
+{
+    cl_int errNum;
 
-    // Set the args values and check for errors
-    errNum |= clSetKernelArg(initializeBuffersKernel, 0, sizeof(cl_mem), &maskArrayDevice);
-    errNum |= clSetKernelArg(initializeBuffersKernel, 1, sizeof(cl_mem), &costArrayDevice);
-    errNum |= clSetKernelArg(initializeBuffersKernel, 2, sizeof(cl_mem), &updatingCostArrayDevice);
+    this->release_graph();
 
-    // 3 set below in loop
-    auto vertex_count = graph.vertex_array.size();
-    auto edge_count = graph.edge_array.size();
-    errNum |= clSetKernelArg(initializeBuffersKernel, 4, sizeof(int), &vertex_count);
-    check_error(errNum, CL_SUCCESS);
+    this->vertex_count = static_cast<int>(graph.vertex_array.size());
+    this->edge_count = static_cast<int>(graph.edge_array.size());
+    // Set # of work items in work group and total in 1 dimensional range
+    this->global_work_size = roundWorkSizeUp(this->max_work_group_size, this->vertex_count);
+
+    // Zero-sized buffers are invalid, an edgeless graph still gets one element
+    auto edge_slots = std::max<size_t>(1, this->edge_count);
 
-    // Kernel 1
-    cl_kernel ssspKernel1;
-    ssspKernel1 = clCreateKernel(program, "OCL_SSSP_KERNEL1", &errNum);
+    // The per-vertex buffers are padded to the work size: the padding work
+    // items read them, but never have their mask set
+    this->vertex_array = clCreateBuffer(this->context, CL_MEM_READ_ONLY, sizeof(int) * this->global_work_size, NULL, &errNum);
     check_error(errNum, CL_SUCCESS);
-    errNum |= clSetKernelArg(ssspKernel1, 0, sizeof(cl_mem), &vertexArrayDevice);
-    errNum |= clSetKernelArg(ssspKernel1, 1, sizeof(cl_mem), &edgeArrayDevice);
-    errNum |= clSetKernelArg(ssspKernel1, 2, sizeof(cl_mem), &weightArrayDevice);
-    errNum |= clSetKernelArg(ssspKernel1, 3, sizeof(cl_mem), &maskArrayDevice);
-    errNum |= clSetKernelArg(ssspKernel1, 4, sizeof(cl_mem), &costArrayDevice);
-    errNum |= clSetKernelArg(ssspKernel1, 5, sizeof(cl_mem), &updatingCostArrayDevice);
-    errNum |= clSetKernelArg(ssspKernel1, 6, sizeof(int), &vertex_count);
-    errNum |= clSetKernelArg(ssspKernel1, 7, sizeof(int), &edge_count);
+    this->edge_array = clCreateBuffer(this->context, CL_MEM_READ_ONLY, sizeof(int) * edge_slots, NULL, &errNum);
     check_error(errNum, CL_SUCCESS);
-
-    // Kernel 2
-    cl_kernel ssspKernel2;
-    ssspKernel2 = clCreateKernel(program, "OCL_SSSP_KERNEL2", &errNum);
+    this->weight_array = clCreateBuffer(this->context, CL_MEM_READ_ONLY, sizeof(float) * edge_slots, NULL, &errNum);
+    check_error(errNum, CL_SUCCESS);
+    this->mask_array = clCreateBuffer(this->context, CL_MEM_READ_WRITE, sizeof(int) * this->global_work_size, NULL, &errNum);
+    check_error(errNum, CL_SUCCESS);
+    this->cost_array = clCreateBuffer(this->context, CL_MEM_READ_WRITE, sizeof(float) * this->global_work_size, NULL, &errNum);
+    check_error(errNum, CL_SUCCESS);
+    this->updating_cost_array = clCreateBuffer(this->context, CL_MEM_READ_WRITE, sizeof(float) * this->global_work_size, NULL, &errNum);
+    check_error(errNum, CL_SUCCESS);
+    this->parent_array = clCreateBuffer(this->context, CL_MEM_READ_WRITE, sizeof(int) * this->global_work_size, NULL, &errNum);
+    check_error(errNum, CL_SUCCESS);
+    this->queued_array = clCreateBuffer(this->context, CL_MEM_READ_WRITE, sizeof(int) * this->global_work_size, NULL, &errNum);
+    check_error(errNum, CL_SUCCESS);
+    for (auto &frontier : this->frontiers)
+    {
+        frontier = clCreateBuffer(this->context, CL_MEM_READ_WRITE, sizeof(int) * this->global_work_size, NULL, &errNum);
+        check_error(errNum, CL_SUCCESS);
+    }
+    this->frontier_size = clCreateBuffer(this->context, CL_MEM_READ_WRITE, sizeof(int), NULL, &errNum);
     check_error(errNum, CL_SUCCESS);
-    errNum |= clSetKernelArg(ssspKernel2, 0, sizeof(cl_mem), &vertexArrayDevice);
-    errNum |= clSetKernelArg(ssspKernel2, 1, sizeof(cl_mem), &edgeArrayDevice);
-    errNum |= clSetKernelArg(ssspKernel2, 2, sizeof(cl_mem), &weightArrayDevice);
-    errNum |= clSetKernelArg(ssspKernel2, 3, sizeof(cl_mem), &maskArrayDevice);
-    errNum |= clSetKernelArg(ssspKernel2, 4, sizeof(cl_mem), &costArrayDevice);
-    errNum |= clSetKernelArg(ssspKernel2, 5, sizeof(cl_mem), &updatingCostArrayDevice);
-    errNum |= clSetKernelArg(ssspKernel2, 6, sizeof(int), &vertex_count);
 
+    // Copy the graph, the writes complete before any kernel of the in-order queue runs
+    errNum = clEnqueueWriteBuffer(this->queue, this->vertex_array, CL_FALSE, 0, sizeof(int) * this->vertex_count,
+                                  graph.vertex_array.data(), 0, NULL, NULL);
     check_error(errNum, CL_SUCCESS);
+    if (this->edge_count > 0)
+    {
+        errNum = clEnqueueWriteBuffer(this->queue, this->edge_array, CL_FALSE, 0, sizeof(int) * this->edge_count,
+                                      graph.edge_array.data(), 0, NULL, NULL);
+        check_error(errNum, CL_SUCCESS);
+        errNum = clEnqueueWriteBuffer(this->queue, this->weight_array, CL_FALSE, 0, sizeof(float) * this->edge_count,
+                                      graph.weight_array.data(), 0, NULL, NULL);
+        check_error(errNum, CL_SUCCESS);
+    }
+    // The host arrays may go away after this call
+    clFinish(this->queue);
+
+    // Bind the buffers once, only the source vertex changes between queries
+    errNum = CL_SUCCESS;
+    errNum |= clSetKernelArg(this->initialize_kernel, 0, sizeof(cl_mem), &this->mask_array);
+    errNum |= clSetKernelArg(this->initialize_kernel, 1, sizeof(cl_mem), &this->cost_array);
+    errNum |= clSetKernelArg(this->initialize_kernel, 2, sizeof(cl_mem), &this->updating_cost_array);
+    errNum |= clSetKernelArg(this->initialize_kernel, 4, sizeof(int), &this->vertex_count);
+
+    cl_kernel sssp_kernels[] = { this->sssp_kernel1, this->sssp_kernel2 };
+    for (auto kernel : sssp_kernels)
+    {
+        errNum |= clSetKernelArg(kernel, 0, sizeof(cl_mem), &this->vertex_array);
+        errNum |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &this->edge_array);
+        errNum |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &this->weight_array);
+        errNum |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &this->mask_array);
+        errNum |= clSetKernelArg(kernel, 4, sizeof(cl_mem), &this->cost_array);
+        errNum |= clSetKernelArg(kernel, 5, sizeof(cl_mem), &this->updating_cost_array);
+        errNum |= clSetKernelArg(kernel, 6, sizeof(int), &this->vertex_count);
+    }
+    errNum |= clSetKernelArg(this->sssp_kernel1, 7, sizeof(int), &this->edge_count);
+    // The legacy loop counts its next frontier in the same counter as the compacted one
+    errNum |= clSetKernelArg(this->sssp_kernel2, 7, sizeof(cl_mem), &this->frontier_size);
+
+    errNum |= clSetKernelArg(this->parents_kernel, 0, sizeof(cl_mem), &this->vertex_array);
+    errNum |= clSetKernelArg(this->parents_kernel, 1, sizeof(cl_mem), &this->edge_array);
+    errNum |= clSetKernelArg(this->parents_kernel, 2, sizeof(cl_mem), &this->weight_array);
+    errNum |= clSetKernelArg(this->parents_kernel, 3, sizeof(cl_mem), &this->cost_array);
+    errNum |= clSetKernelArg(this->parents_kernel, 4, sizeof(cl_mem), &this->parent_array);
+    errNum |= clSetKernelArg(this->parents_kernel, 6, sizeof(int), &this->vertex_count);
+    errNum |= clSetKernelArg(this->parents_kernel, 7, sizeof(int), &this->edge_count);
+
+    errNum |= clSetKernelArg(this->frontier_init_kernel, 0, sizeof(cl_mem), &this->cost_array);
+    errNum |= clSetKernelArg(this->frontier_init_kernel, 1, sizeof(cl_mem), &this->queued_array);
+    errNum |= clSetKernelArg(this->frontier_init_kernel, 2, sizeof(cl_mem), &this->frontiers[0]);
+    errNum |= clSetKernelArg(this->frontier_init_kernel, 4, sizeof(int), &this->vertex_count);
+
+    // 5, 6 and 7 (the current and the next frontier) alternate every iteration
+    errNum |= clSetKernelArg(this->frontier_relax_kernel, 0, sizeof(cl_mem), &this->vertex_array);
+    errNum |= clSetKernelArg(this->frontier_relax_kernel, 1, sizeof(cl_mem), &this->edge_array);
+    errNum |= clSetKernelArg(this->frontier_relax_kernel, 2, sizeof(cl_mem), &this->weight_array);
+    errNum |= clSetKernelArg(this->frontier_relax_kernel, 3, sizeof(cl_mem), &this->cost_array);
+    errNum |= clSetKernelArg(this->frontier_relax_kernel, 4, sizeof(cl_mem), &this->queued_array);
+    errNum |= clSetKernelArg(this->frontier_relax_kernel, 8, sizeof(cl_mem), &this->frontier_size);
+    errNum |= clSetKernelArg(this->frontier_relax_kernel, 9, sizeof(int), &this->vertex_count);
+    errNum |= clSetKernelArg(this->frontier_relax_kernel, 10, sizeof(int), &this->edge_count);
+    check_error(errNum, CL_SUCCESS);
+
+    this->graph_revision = graph.Revision();
+}
+
+bool OpenCLEngine::prepare(const Graph &graph)
+{
+    if (!this->IsReady() || graph.vertex_array.empty())
+    {
+        return false;
+    }
+
+    if (this->graph_revision == 0 || this->graph_revision != graph.Revision())
+    {
+        this->upload_graph(graph);
+    }
+    return true;
+}
 
-    int *maskArrayHost = new int[graph.vertex_array.size()];
+void OpenCLEngine::read_results(int source_vertex, std::vector<float> &costs, std::vector<int> *parents)
+{
+    cl_int errNum;
 
-    errNum |= clSetKernelArg(initializeBuffersKernel, 3, sizeof(int), &source_vertex);
+    // Copy the result back
+    costs.resize(this->vertex_count);
+    errNum = clEnqueueReadBuffer(this->queue, this->cost_array, CL_TRUE, 0, sizeof(float) * this->vertex_count,
+                                 costs.data(), 0, NULL, NULL);
     check_error(errNum, CL_SUCCESS);
 
-    // Initialize mask array to false, C and U to infiniti
-    init_ocl_buffers(commandQueue, initializeBuffersKernel, graph, maxWorkGroupSize);
+    // Shortest path tree from the final costs
+    if (parents != nullptr)
+    {
+        parents->assign(this->vertex_count, DIJKSTRA_NO_PARENT);
+        (*parents)[source_vertex] = source_vertex;
+
+        errNum = clEnqueueWriteBuffer(this->queue, this->parent_array, CL_FALSE, 0, sizeof(int) * this->vertex_count,
+                                      parents->data(), 0, NULL, NULL);
+        check_error(errNum, CL_SUCCESS);
 
-    // Read mask array from device -> host
-    cl_event readDone;
-    errNum = clEnqueueReadBuffer(commandQueue, maskArrayDevice, CL_FALSE, 0, sizeof(int) * graph.vertex_array.size(),
-                                 maskArrayHost, 0, NULL, &readDone);
+        errNum = clSetKernelArg(this->parents_kernel, 5, sizeof(int), &source_vertex);
+        check_error(errNum, CL_SUCCESS);
+        errNum = clEnqueueNDRangeKernel(this->queue, this->parents_kernel, 1, 0, &this->global_work_size, NULL,
+                                        0, NULL, NULL);
+        check_error(errNum, CL_SUCCESS);
+
+        errNum = clEnqueueReadBuffer(this->queue, this->parent_array, CL_TRUE, 0, sizeof(int) * this->vertex_count,
+                                     parents->data(), 0, NULL, NULL);
+        check_error(errNum, CL_SUCCESS);
+    }
+}
+
+std::vector<float> OpenCLEngine::Run(const Graph &graph, int source_vertex, std::vector<int> *parents)
+{
+    std::vector<float> shortest_path;
+    if (!this->prepare(graph))
+    {
+        return shortest_path;
+    }
+
+    cl_int errNum;
+
+    // Initialize mask array to false, C and U to infiniti
+    errNum = clSetKernelArg(this->initialize_kernel, 3, sizeof(int), &source_vertex);
+    check_error(errNum, CL_SUCCESS);
+    errNum = clEnqueueNDRangeKernel(this->queue, this->initialize_kernel, 1, NULL, &this->global_work_size, NULL,
+                                    0, NULL, NULL);
     check_error(errNum, CL_SUCCESS);
-    clWaitForEvents(1, &readDone);
 
-    while (!maskArrayEmpty(maskArrayHost, graph.vertex_array.size()))
+    // In order to improve performance, we run a batch of iterations without
+    // reading anything back.  Only the last iteration of a batch counts the
+    // vertices it puts back into the mask, so a batch costs one 4-byte read
+    // instead of a copy and a scan of the whole mask.  The batch size follows
+    // the counter, see AdaptiveBatch.
+    const int zero = 0;
+    AdaptiveBatch batch;
+    int changed_count = 1;
+    while (changed_count > 0)
     {
-        // In order to improve performance, we run some number of iterations
-        // without reading the results.  This might result in running more iterations
-        // than necessary at times, but it will in most cases be faster because
-        // we are doing less stalling of the GPU waiting for results.
-        for (int asyncIter = 0; asyncIter < NUM_ASYNCHRONOUS_ITERATIONS; asyncIter++)
+        auto iterations = batch.Size();
+        for (int asyncIter = 0; asyncIter < iterations; asyncIter++)
         {
-            size_t globalWorkSize = roundWorkSizeUp(maxWorkGroupSize, graph.vertex_array.size());
-
             // execute the kernel
-            errNum = clEnqueueNDRangeKernel(commandQueue, ssspKernel1, 1, 0, &globalWorkSize, NULL,
+            errNum = clEnqueueNDRangeKernel(this->queue, this->sssp_kernel1, 1, 0, &this->global_work_size, NULL,
                                             0, NULL, NULL);
             check_error(errNum, CL_SUCCESS);
 
-            errNum = clEnqueueNDRangeKernel(commandQueue, ssspKernel2, 1, 0, &globalWorkSize, NULL,
+            if (asyncIter == iterations - 1)
+            {
+                errNum = clEnqueueWriteBuffer(this->queue, this->frontier_size, CL_FALSE, 0, sizeof(int), &zero,
+                                              0, NULL, NULL);
+                check_error(errNum, CL_SUCCESS);
+            }
+
+            errNum = clEnqueueNDRangeKernel(this->queue, this->sssp_kernel2, 1, 0, &this->global_work_size, NULL,
                                             0, NULL, NULL);
             check_error(errNum, CL_SUCCESS);
         }
-        errNum = clEnqueueReadBuffer(commandQueue, maskArrayDevice, CL_FALSE, 0, sizeof(int) * graph.vertex_array.size(),
-                                        maskArrayHost, 0, NULL, &readDone);
+        // Every masked vertex was set by the last KERNEL2, so zero means converged
+        errNum = clEnqueueReadBuffer(this->queue, this->frontier_size, CL_TRUE, 0, sizeof(int), &changed_count,
+                                     0, NULL, NULL);
         check_error(errNum, CL_SUCCESS);
-        clWaitForEvents(1, &readDone);
+        batch.Update(changed_count);
     }
 
-    // Copy the result back
-    errNum = clEnqueueReadBuffer(commandQueue, costArrayDevice, CL_FALSE, 0, sizeof(float) * graph.vertex_array.size(),
-                                 shortest_path.data(), 0, NULL, &readDone);
+    this->read_results(source_vertex, shortest_path, parents);
+    return shortest_path;
+}
+
+std::vector<float> OpenCLEngine::RunFrontier(const Graph &graph, int source_vertex, std::vector<int> *parents)
+{
+    std::vector<float> shortest_path;
+    if (!this->prepare(graph))
+    {
+        return shortest_path;
+    }
+
+    cl_int errNum;
+    const int zero = 0;
+
+    // Costs to infinity, the frontier to { source_vertex }
+    errNum = clSetKernelArg(this->frontier_init_kernel, 3, sizeof(int), &source_vertex);
+    check_error(errNum, CL_SUCCESS);
+    errNum = clEnqueueNDRangeKernel(this->queue, this->frontier_init_kernel, 1, NULL, &this->global_work_size, NULL,
+                                    0, NULL, NULL);
     check_error(errNum, CL_SUCCESS);
-    clWaitForEvents(1, &readDone);
 
+    int current = 0;
+    int frontier_count = 1;
+    while (frontier_count > 0)
+    {
+        size_t frontier_work_size = roundWorkSizeUp(this->max_work_group_size, frontier_count);
+
+        errNum = clEnqueueWriteBuffer(this->queue, this->frontier_size, CL_FALSE, 0, sizeof(int), &zero,
+                                      0, NULL, NULL);
+        check_error(errNum, CL_SUCCESS);
 
-    delete[] maskArrayHost;
+        errNum = CL_SUCCESS;
+        errNum |= clSetKernelArg(this->frontier_relax_kernel, 5, sizeof(cl_mem), &this->frontiers[current]);
+        errNum |= clSetKernelArg(this->frontier_relax_kernel, 6, sizeof(int), &frontier_count);
+        errNum |= clSetKernelArg(this->frontier_relax_kernel, 7, sizeof(cl_mem), &this->frontiers[1 - current]);
+        check_error(errNum, CL_SUCCESS);
 
-    clReleaseMemObject(vertexArrayDevice);
-    clReleaseMemObject(edgeArrayDevice);
-    clReleaseMemObject(weightArrayDevice);
-    clReleaseMemObject(maskArrayDevice);
-    clReleaseMemObject(costArrayDevice);
-    clReleaseMemObject(updatingCostArrayDevice);
+        errNum = clEnqueueNDRangeKernel(this->queue, this->frontier_relax_kernel, 1, NULL, &frontier_work_size, NULL,
+                                        0, NULL, NULL);
+        check_error(errNum, CL_SUCCESS);
 
-    clReleaseKernel(initializeBuffersKernel);
-    clReleaseKernel(ssspKernel1);
-    clReleaseKernel(ssspKernel2);
+        // Only the size of the next frontier comes back, not a V-sized mask
+        errNum = clEnqueueReadBuffer(this->queue, this->frontier_size, CL_TRUE, 0, sizeof(int), &frontier_count,
+                                     0, NULL, NULL);
+        check_error(errNum, CL_SUCCESS);
 
-    clReleaseCommandQueue(commandQueue);
-    clReleaseProgram(program);
+        current = 1 - current;
+    }
 
+    this->read_results(source_vertex, shortest_path, parents);
     return shortest_path;
 }
 
-
-///
-/// Check whether the mask array is empty.  This tells the algorithm whether
-/// it needs to continue running or not.
-///
-bool maskArrayEmpty(int *maskArray, int count)
+OpenCLEngine &opencl_engine(cl_context context)
 {
-    for(int i = 0; i < count; i++ )
+    static std::map<cl_context, std::unique_ptr<OpenCLEngine>> engines;
+    static pthread_mutex_t engines_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+    pthread_mutex_lock(&engines_mtx);
+    auto &engine = engines[context];
+    if (!engine)
     {
-        if (maskArray[i] == 1)
-        {
-            return false;
-        }
+        engine.reset(new OpenCLEngine(context));
     }
+    pthread_mutex_unlock(&engines_mtx);
 
-    return true;
+    return *engine;
 }
 
+
 ocl_init_result_t dijkstra_init_contexts(cl_context &gpu_context, cl_context &cpu_context)
 {
     cl_platform_id platform;
@@ -554,7 +775,14 @@ ocl_init_result_t dijkstra_init_contexts(cl_context &gpu_context, cl_context &cp
     return OCL_INIT_SUCCESS;
 }
 
-std::vector<float> dijkstra_opencl(const Graph &graph, int source_vertex, cl_context &opencl_context)
+std::vector<float> dijkstra_opencl(const Graph &graph, int source_vertex, cl_context &opencl_context,
+                                   std::vector<int> *parents)
+{
+    return opencl_engine(opencl_context).Run(graph, source_vertex, parents);
+}
+
+std::vector<float> dijkstra_opencl_frontier(const Graph &graph, int source_vertex, cl_context &opencl_context,
+                                            std::vector<int> *parents)
 {
-    return run_dijkstra(opencl_context, get_max_flops_dev(opencl_context), graph, source_vertex);
+    return opencl_engine(opencl_context).RunFrontier(graph, source_vertex, parents);
 }
@@ -0,0 +1,223 @@
+#include "src/dijkstra.hpp"
+#include "common/atomics.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+
+#include <omp.h>
+
+// Bucket index used for vertices that were never reached
+#define NO_BUCKET ULLONG_MAX
+// Cyclic buckets per thread at most; a narrower delta is widened to fit
+#define DELTA_MAX_BUCKETS 65536
+
+///
+/// Bucket width used when the caller does not provide one: the classic
+/// Meyer-Sanders choice of the maximum edge weight divided by the average degree.
+///
+static float default_delta(const Graph &graph)
+{
+    auto max_weight = graph.MaxWeight();
+    auto average_degree = graph.vertex_array.empty() ? 1.f : static_cast<float>(graph.edge_array.size()) / graph.vertex_array.size();
+    auto delta = max_weight / std::max(average_degree, 1.f);
+
+    return delta > 0.f ? delta : 1.f;
+}
+
+std::vector<float> dijkstra_delta_stepping(const Graph &graph,
+                                           int source_vertex,
+                                           std::vector<int> *parents)
+{
+    return dijkstra_delta_stepping(graph, source_vertex, default_delta(graph), parents);
+}
+
+std::vector<float> dijkstra_delta_stepping(const Graph &graph,
+                                           int source_vertex,
+                                           float delta,
+                                           std::vector<int> *parents)
+{
+    auto number_of_vertexes = static_cast<int>(graph.vertex_array.size());
+    auto number_of_edges = graph.edge_array.size();
+
+    std::vector<std::atomic<float>> distances(number_of_vertexes);
+
+    // Every pending vertex lies within max_weight of the current bucket, so a
+    // cyclic array of buckets covering that window (plus a margin against
+    // rounding in the division) is enough.  Each thread keeps that many, so a
+    // delta far below the largest weight is widened to DELTA_MAX_BUCKETS
+    auto max_weight = graph.MaxWeight();
+    if (max_weight / delta > DELTA_MAX_BUCKETS - 4)
+    {
+        delta = max_weight / (DELTA_MAX_BUCKETS - 4);
+    }
+    auto number_of_buckets = static_cast<unsigned long long>(max_weight / delta) + 3;
+    auto bucket_of = [delta](float distance) { return static_cast<unsigned long long>(distance / delta); };
+
+    // --- Light/heavy split: a copy of the CSR arrays in which the light edges
+    //     (weight <= delta) of every vertex come first, followed by the heavy ones
+    std::vector<int> split_edges(number_of_edges);
+    std::vector<float> split_weights(number_of_edges);
+    std::vector<int> light_end(number_of_vertexes);
+
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (int v = 0; v < number_of_vertexes; ++v)
+    {
+        distances[v].store(FLT_MAX, std::memory_order_relaxed);
+
+        auto edge_begin = graph.EdgesBegin(v);
+        auto edge_end = graph.EdgesEnd(v);
+        auto light = edge_begin;
+        auto heavy = edge_end;
+        for (auto edge = edge_begin; edge < edge_end; ++edge)
+        {
+            auto weight = graph.weight_array[edge];
+            auto slot = weight <= delta ? light++ : --heavy;
+            split_edges[slot] = graph.edge_array[edge];
+            split_weights[slot] = weight;
+        }
+        light_end[v] = light;
+    }
+
+    auto number_of_threads = omp_get_max_threads();
+    std::vector<int> frontier;
+    std::vector<size_t> frontier_offsets(number_of_threads + 1);
+    std::vector<unsigned long long> thread_next_bucket(number_of_threads);
+    unsigned long long current_bucket = 0;
+
+    // distances of the source vertex from itself is always 0
+    distances[source_vertex].store(0.f, std::memory_order_relaxed);
+
+    #pragma omp parallel num_threads(number_of_threads)
+    {
+        auto thread_id = omp_get_thread_num();
+
+        // Per-thread bucket buffers, a vertex lands in the buffer of the thread that relaxed it
+        std::vector<std::vector<int>> buckets(number_of_buckets);
+        std::vector<int> taken;
+        std::vector<int> settled;
+
+        if (thread_id == 0)
+        {
+            buckets[0].push_back(source_vertex);
+        }
+
+        // Relax the [first, last) part of the split adjacency of u and file improved vertices
+        auto relax = [&](int u, int first, int last)
+        {
+            auto distance_u = distances[u].load(std::memory_order_relaxed);
+            for (auto edge = first; edge < last; ++edge)
+            {
+                auto v = split_edges[edge];
+                auto candidate = distance_u + split_weights[edge];
+                if (atomic_min(distances[v], candidate))
+                {
+                    buckets[bucket_of(candidate) % number_of_buckets].push_back(v);
+                }
+            }
+        };
+
+        // Concatenate the `taken` buffers of all threads into the shared frontier
+        auto gather = [&]() -> size_t
+        {
+            frontier_offsets[thread_id + 1] = taken.size();
+            #pragma omp barrier
+            #pragma omp single
+            {
+                frontier_offsets[0] = 0;
+                for (auto t = 0; t < number_of_threads; ++t)
+                {
+                    frontier_offsets[t + 1] += frontier_offsets[t];
+                }
+                frontier.resize(frontier_offsets[number_of_threads]);
+            }
+            // Read the total before the barrier, the offsets are rewritten right after it
+            auto total = frontier_offsets[number_of_threads];
+            std::copy(taken.begin(), taken.end(), frontier.begin() + frontier_offsets[thread_id]);
+            #pragma omp barrier
+            return total;
+        };
+
+        while (true)
+        {
+            // --- Find the next non-empty bucket over all threads
+            thread_next_bucket[thread_id] = NO_BUCKET;
+            for (auto i = current_bucket; i < current_bucket + number_of_buckets; ++i)
+            {
+                if (!buckets[i % number_of_buckets].empty())
+                {
+                    thread_next_bucket[thread_id] = i;
+                    break;
+                }
+            }
+            #pragma omp barrier
+            #pragma omp single
+            {
+                current_bucket = *std::min_element(thread_next_bucket.begin(), thread_next_bucket.end());
+            }
+
+            if (current_bucket == NO_BUCKET)
+            {
+                break;
+            }
+
+            // --- Light edges: may refill the current bucket, so repeat until it stays empty
+            settled.clear();
+            while (true)
+            {
+                taken.clear();
+                taken.swap(buckets[current_bucket % number_of_buckets]);
+                settled.insert(settled.end(), taken.begin(), taken.end());
+
+                if (gather() == 0)
+                {
+                    break;
+                }
+
+                #pragma omp for schedule(dynamic, 64)
+                for (auto i = 0LL; i < static_cast<long long>(frontier.size()); ++i)
+                {
+                    auto u = frontier[i];
+                    // Skip stale entries, u has been moved to an earlier bucket meanwhile
+                    if (bucket_of(distances[u].load(std::memory_order_relaxed)) != current_bucket)
+                    {
+                        continue;
+                    }
+                    relax(u, graph.EdgesBegin(u), light_end[u]);
+                }
+            }
+
+            // --- Heavy edges of everything settled in this bucket, once
+            taken.swap(settled);
+            gather();
+
+            #pragma omp for schedule(dynamic, 64)
+            for (auto i = 0LL; i < static_cast<long long>(frontier.size()); ++i)
+            {
+                auto u = frontier[i];
+                if (bucket_of(distances[u].load(std::memory_order_relaxed)) != current_bucket)
+                {
+                    continue;
+                }
+                relax(u, light_end[u], graph.EdgesEnd(u));
+            }
+        }
+    }
+
+    std::vector<float> result(number_of_vertexes);
+
+    #pragma omp parallel for
+    for (int v = 0; v < number_of_vertexes; ++v)
+    {
+        result[v] = distances[v].load(std::memory_order_relaxed);
+    }
+
+    // Recording the parent in the relaxation would need a CAS on a
+    // (distance, parent) pair, a pass over the tight edges is cheaper
+    if (parents != nullptr)
+    {
+        dijkstra_parents_from_distances(graph, source_vertex, result, *parents);
+    }
+
+    return result;
+}
@@ -0,0 +1,125 @@
+#include "src/dijkstra.hpp"
+#include "common/atomics.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+#include <omp.h>
+
+///
+/// The algorithm of the GPU backends (Harish and Narayanan: mask, cost and
+/// updating cost arrays, two kernels per iteration) on CPU threads.  The mask
+/// is kept as an explicit frontier, so neither kernel walks all V vertices:
+///
+///   Kernel 1 -- every frontier vertex relaxes its edges into the updating
+///               costs with an atomic min; a vertex whose updating cost went
+///               down is collected once, through its `queued` flag.
+///   Kernel 2 -- the collected vertices copy their updating cost into the
+///               cost array and form the next frontier.
+///
+/// The run ends when kernel 1 lowers no updating cost, i.e. the frontier is
+/// empty.
+///
+std::vector<float> dijkstra_harish_narayanan(const Graph &graph,
+                                             int source_vertex,
+                                             std::vector<int> *parents)
+{
+    auto number_of_vertexes = static_cast<int>(graph.vertex_array.size());
+
+    std::vector<float> distances(number_of_vertexes, FLT_MAX);
+    std::vector<std::atomic<float>> updating_distances(number_of_vertexes);
+    std::vector<std::atomic<bool>> queued(number_of_vertexes);
+
+    #pragma omp parallel for
+    for (int v = 0; v < number_of_vertexes; ++v)
+    {
+        updating_distances[v].store(FLT_MAX, std::memory_order_relaxed);
+        queued[v].store(false, std::memory_order_relaxed);
+    }
+
+    // distances of the source vertex from itself is always 0
+    distances[source_vertex] = 0.f;
+    updating_distances[source_vertex].store(0.f, std::memory_order_relaxed);
+
+    auto number_of_threads = omp_get_max_threads();
+    std::vector<int> frontier(1, source_vertex);
+    std::vector<size_t> frontier_offsets(number_of_threads + 1);
+
+    #pragma omp parallel num_threads(number_of_threads)
+    {
+        auto thread_id = omp_get_thread_num();
+
+        // Vertices this thread lowered in kernel 1
+        std::vector<int> lowered;
+
+        // Replace the shared frontier with the `lowered` buffers of all threads
+        auto gather = [&]() -> size_t
+        {
+            frontier_offsets[thread_id + 1] = lowered.size();
+            #pragma omp barrier
+            #pragma omp single
+            {
+                frontier_offsets[0] = 0;
+                for (auto t = 0; t < number_of_threads; ++t)
+                {
+                    frontier_offsets[t + 1] += frontier_offsets[t];
+                }
+                frontier.resize(frontier_offsets[number_of_threads]);
+            }
+            // Read the total before the barrier, the offsets are rewritten right after it
+            auto total = frontier_offsets[number_of_threads];
+            std::copy(lowered.begin(), lowered.end(), frontier.begin() + frontier_offsets[thread_id]);
+            #pragma omp barrier
+            return total;
+        };
+
+        while (true)
+        {
+            // --- Kernel 1: relax the edges of the frontier into the updating costs
+            lowered.clear();
+
+            #pragma omp for schedule(dynamic, 64)
+            for (auto i = 0LL; i < static_cast<long long>(frontier.size()); ++i)
+            {
+                auto u = frontier[i];
+                auto distance_u = distances[u];
+
+                auto edge_end = graph.EdgesEnd(u);
+                for (auto edge = graph.EdgesBegin(u); edge < edge_end; ++edge)
+                {
+                    auto v = graph.edge_array[edge];
+                    if (atomic_min(updating_distances[v], distance_u + graph.weight_array[edge]) &&
+                        !queued[v].exchange(true, std::memory_order_relaxed))
+                    {
+                        lowered.push_back(v);
+                    }
+                }
+            }
+
+            if (gather() == 0)
+            {
+                break;
+            }
+
+            // --- Kernel 2: the lowered vertices take their updating cost and
+            //     are the next frontier (an atomic min only succeeds below the
+            //     cost, which the updating cost always starts from)
+            #pragma omp for schedule(static)
+            for (auto i = 0LL; i < static_cast<long long>(frontier.size()); ++i)
+            {
+                auto v = frontier[i];
+                queued[v].store(false, std::memory_order_relaxed);
+                distances[v] = updating_distances[v].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Same post-pass as delta-stepping, recording parents in kernel 1 would
+    // need a CAS on a (distance, parent) pair
+    if (parents != nullptr)
+    {
+        dijkstra_parents_from_distances(graph, source_vertex, distances, *parents);
+    }
+
+    return distances;
+}
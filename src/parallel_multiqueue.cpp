@@ -0,0 +1,116 @@
+#include "src/dijkstra.hpp"
+#include "common/atomics.hpp"
+#include "common/multi_queue.hpp"
+
+#include <atomic>
+
+#include <omp.h>
+
+// Heaps per thread; two keep the pops close to the global minimum while a
+// thread still mostly works on its own heaps
+#define MULTIQUEUE_QUEUES_PER_THREAD 2
+
+std::vector<float> dijkstra_multiqueue(const Graph &graph,
+                                       int source_vertex,
+                                       std::vector<int> *parents,
+                                       MultiQueueStats *stats)
+{
+    auto number_of_vertexes = static_cast<int>(graph.vertex_array.size());
+    auto number_of_threads = omp_get_max_threads();
+
+    std::vector<std::atomic<float>> distances(number_of_vertexes);
+
+    #pragma omp parallel for
+    for (int v = 0; v < number_of_vertexes; ++v)
+    {
+        distances[v].store(FLT_MAX, std::memory_order_relaxed);
+    }
+
+    MultiQueue<float> queue(number_of_threads, MULTIQUEUE_QUEUES_PER_THREAD);
+
+    // Entries in the queue plus vertices being expanded.  An expansion pushes
+    // its improvements before it retires its own entry, so the count only
+    // reaches zero when no work is left anywhere.
+    std::atomic<long long> pending(1);
+
+    long long pops = 0;
+    long long stale_pops = 0;
+    long long expansions = 0;
+
+    // distances of the source vertex from itself is always 0
+    distances[source_vertex].store(0.f, std::memory_order_relaxed);
+    {
+        CounterRng rng(0, 0);
+        queue.Push(0, source_vertex, 0.f, rng);
+    }
+
+    #pragma omp parallel num_threads(number_of_threads) reduction(+ : pops, stale_pops, expansions)
+    {
+        auto thread_id = omp_get_thread_num();
+        CounterRng rng(0x4D51, thread_id);
+
+        int u;
+        float distance_u;
+        while (true)
+        {
+            if (!queue.TryPop(thread_id, u, distance_u, rng))
+            {
+                if (pending.load() == 0)
+                {
+                    break;
+                }
+                continue;
+            }
+            ++pops;
+
+            // A better path to u was found after this entry was pushed, that
+            // entry expands u instead
+            if (distances[u].load(std::memory_order_relaxed) < distance_u)
+            {
+                ++stale_pops;
+                pending.fetch_sub(1);
+                continue;
+            }
+            ++expansions;
+
+            auto edge_end = graph.EdgesEnd(u);
+            for (auto edge = graph.EdgesBegin(u); edge < edge_end; ++edge)
+            {
+                auto v = graph.edge_array[edge];
+                auto candidate = distance_u + graph.weight_array[edge];
+                if (atomic_min(distances[v], candidate))
+                {
+                    pending.fetch_add(1);
+                    queue.Push(thread_id, v, candidate, rng);
+                }
+            }
+            pending.fetch_sub(1);
+        }
+    }
+
+    std::vector<float> result(number_of_vertexes);
+    long long reached = 0;
+
+    #pragma omp parallel for reduction(+ : reached)
+    for (int v = 0; v < number_of_vertexes; ++v)
+    {
+        result[v] = distances[v].load(std::memory_order_relaxed);
+        reached += result[v] < FLT_MAX ? 1 : 0;
+    }
+
+    if (stats != nullptr)
+    {
+        stats->pops = pops;
+        stats->stale_pops = stale_pops;
+        stats->expansions = expansions;
+        stats->reached = reached;
+    }
+
+    // Same post-pass as delta-stepping, the relaxations race on the distances
+    if (parents != nullptr)
+    {
+        dijkstra_parents_from_distances(graph, source_vertex, result, *parents);
+    }
+
+    return result;
+}
@@ -1,80 +1,208 @@
 #include "src/dijkstra.hpp"
+#include "common/argmin.hpp"
 
-#include <iostream>
-#include <chrono>
+#include <algorithm>
+#include <cstdint>
 
 #include <omp.h>
 
+// Partitions of the per-vertex arrays are whole cache lines of floats
+#define FLOATS_PER_CACHE_LINE 16
+
+///
+/// Candidate for the next vertex to finalize.  Ties go to the smaller vertex,
+/// so the order of finalization (and the parents) does not depend on the
+/// number of threads.
+///
+struct VertexDistance
+{
+    float distance;
+    int vertex;
+};
+
+#pragma omp declare reduction(vertex_min : VertexDistance :                                           \
+        omp_out = (omp_in.distance < omp_out.distance ||                                              \
+                   (omp_in.distance == omp_out.distance && omp_in.vertex < omp_out.vertex)) ? omp_in  \
+                                                                                            : omp_out) \
+        initializer(omp_priv = VertexDistance{ ARGMIN_MASKED, -1 })
+
+///
+/// First element of partition `partition` out of `partitions` over `count`
+/// floats at `data`.  Every boundary but the first is a 64-byte aligned
+/// address, so two threads never write the same cache line.
+///
+static int partition_begin(const float *data, int count, int partitions, int partition)
+{
+    if (partition == 0)
+    {
+        return 0;
+    }
+
+    auto misalignment = static_cast<int>(reinterpret_cast<uintptr_t>(data) / sizeof(float) % FLOATS_PER_CACHE_LINE);
+    auto first_aligned = (FLOATS_PER_CACHE_LINE - misalignment) % FLOATS_PER_CACHE_LINE;
+    auto chunk = (count + partitions - 1) / partitions;
+    chunk = (chunk + FLOATS_PER_CACHE_LINE - 1) / FLOATS_PER_CACHE_LINE * FLOATS_PER_CACHE_LINE;
+
+    return std::min(count, first_aligned + partition * chunk);
+}
+
 std::vector<float> dijkstra_omp(const Graph &graph,
-                                int source_vertex)
+                                int source_vertex,
+                                std::vector<int> *parents)
 {
-    auto number_of_vetecies = graph.vertex_array.size();
+    auto number_of_vetecies = static_cast<int>(graph.vertex_array.size());
 
-    // finalized_verticies -- true if vertex i is included in the shortest path tree
-    //                      or the shortest distance from the source node to i is
-    //                      finalized
-    std::vector<bool>  finalized_verticies(number_of_vetecies, false);
+    // tentative -- distances of the vertices that are not finalized yet, the
+    //              finalized ones are masked out as ARGMIN_MASKED (see
+    //              dijkstra_sequential)
+    std::vector<float> tentative(number_of_vetecies, FLT_MAX);
     std::vector<float> distances(number_of_vetecies, FLT_MAX);
+    const auto &weight_matrix = graph.WeightMatrix();
+
+    if (parents != nullptr)
+    {
+        parents->assign(number_of_vetecies, DIJKSTRA_NO_PARENT);
+        (*parents)[source_vertex] = source_vertex;
+    }
 
-    std::vector<std::vector<int>> actual_path(number_of_vetecies);
     // distances of the source vertex from itself is always 0
-    distances[source_vertex] = 0.f;
+    tentative[source_vertex] = 0.f;
 
-    // --- Dijkstra iterations
-    for (auto iter_count = 0ULL; iter_count < number_of_vetecies - 1; ++iter_count)
-    {
-        // parallel min_distances funciton
-        int current_vertex = graph.MinDistancesOMP(distances, finalized_verticies, source_vertex);
+    // The vertex to finalize in iteration i is next[i % 3]: iteration i
+    // reduces into next[(i + 1) % 3] and resets next[(i + 2) % 3], which
+    // nobody reads any more after the barrier of iteration i - 1
+    VertexDistance next[3] = { { 0.f, source_vertex }, { ARGMIN_MASKED, -1 }, { ARGMIN_MASKED, -1 } };
 
-        finalized_verticies[current_vertex] = true;
+    // --- One team for the whole run.  Every iteration is a single fused pass
+    //     over the partitions: finalize the current vertex, relax its row and
+    //     pick the next vertex; the barrier of the reduction is the only one.
+    #pragma omp parallel shared(weight_matrix, tentative, distances, parents, next, number_of_vetecies)
+    {
+        auto partitions = omp_get_num_threads();
 
-        #pragma omp parallel shared(graph, finalized_verticies, distances, actual_path, number_of_vetecies)
+        for (auto iter_count = 0; ; ++iter_count)
         {
-            // For all unvisited neighbors of current vertex
-            #pragma omp for
-            for (auto v = 0UL; v < number_of_vetecies; ++v)
+            auto current = next[iter_count % 3];
+            auto slot = (iter_count + 1) % 3;
+
+            // Nothing left, or everything left is unreachable and already at FLT_MAX
+            if (current.vertex < 0 || FLT_MAX == current.distance)
             {
-                if (0 == graph.weight_matrix[current_vertex * number_of_vetecies + v] ||
-                    FLT_MAX == distances[current_vertex])
+                break;
+            }
+
+            #pragma omp master
+            next[(iter_count + 2) % 3] = VertexDistance{ ARGMIN_MASKED, -1 };
+
+            auto row = weight_matrix.data() + static_cast<size_t>(current.vertex) * number_of_vetecies;
+
+            #pragma omp for schedule(static, 1) reduction(vertex_min : next[slot:1])
+            for (auto partition = 0; partition < partitions; ++partition)
+            {
+                auto begin = partition_begin(tentative.data(), number_of_vetecies, partitions, partition);
+                auto end = partition_begin(tentative.data(), number_of_vetecies, partitions, partition + 1);
+
+                if (begin <= current.vertex && current.vertex < end)
                 {
-                    continue;
+                    distances[current.vertex] = current.distance;
+                    tentative[current.vertex] = ARGMIN_MASKED;
                 }
 
-                if (finalized_verticies[v])
+                // For all unvisited neighbors of current vertex
+                for (auto v = begin; v < end; ++v)
                 {
-                    continue;
+                    if (0 == row[v] || ARGMIN_MASKED == tentative[v])
+                    {
+                        continue;
+                    }
+
+                    if (current.distance + row[v] < tentative[v])
+                    {
+                        tentative[v] = current.distance + row[v];
+
+                        // Every v is relaxed by exactly one thread per iteration
+                        if (parents != nullptr)
+                        {
+                            (*parents)[v] = current.vertex;
+                        }
+                    }
                 }
 
-                if (distances[current_vertex] + graph.weight_matrix[current_vertex * number_of_vetecies + v] < distances[v])
+                // The partition is still in this core's cache, the SIMD scan of
+                // it costs much less than tracking the minimum in the loop above
+                auto index = argmin(tentative.data() + begin, end - begin);
+                if (index >= 0 && ARGMIN_MASKED != tentative[begin + index])
                 {
-                    distances[v] = distances[current_vertex] + graph.weight_matrix[current_vertex * number_of_vetecies + v];
-
-                    actual_path[v].push_back(current_vertex);
+                    next[slot] = VertexDistance{ tentative[begin + index], begin + index };
                 }
             }
-            #pragma omp barrier
         }
     }
 
-#if ENABLE_PATH_PRINT != 0
-    std::cout << "Actual paths: " << std::endl;
-    for (auto i = 0ULL; i < actual_path.size(); ++i)
+    return distances;
+}
+
+std::vector<float> dijkstra_omp_csr(const Graph &graph,
+                                    int source_vertex,
+                                    std::vector<int> *parents)
+{
+    auto number_of_vetecies = graph.vertex_array.size();
+
+    std::vector<float> tentative(number_of_vetecies, FLT_MAX);
+    std::vector<float> distances(number_of_vetecies, FLT_MAX);
+
+    if (parents != nullptr)
     {
-        std::cout << "Path from " << source_vertex << " to " << i  << ": ";
-        if (actual_path[i].size() == 0)
+        parents->assign(number_of_vetecies, DIJKSTRA_NO_PARENT);
+        (*parents)[source_vertex] = source_vertex;
+    }
+
+    // distances of the source vertex from itself is always 0
+    tentative[source_vertex] = 0.f;
+
+    // --- Dijkstra iterations
+    for (auto iter_count = 0ULL; iter_count < number_of_vetecies - 1; ++iter_count)
+    {
+        // parallel min_distances funciton
+        int current_vertex = graph.MinDistancesOMP(tentative);
+        auto current_distance = tentative[current_vertex];
+
+        distances[current_vertex] = current_distance;
+        tentative[current_vertex] = ARGMIN_MASKED;
+
+        // Everything left is unreachable and already at FLT_MAX
+        if (FLT_MAX == current_distance)
         {
-            std::cout << "None (Direct?)" << std::endl;
-            continue;
+            break;
         }
 
-        // std::cout << source_vertex << " -> ";
-        for (auto j = 0ULL; j < actual_path[i].size(); ++j)
+        // Only neighbors_per_vertex edges leave the current vertex, which is far
+        // too little work to amortize a parallel region, so the O(V) argmin above
+        // is the only parallel part here
+        auto edge_end = graph.EdgesEnd(current_vertex);
+        for (auto edge = graph.EdgesBegin(current_vertex); edge < edge_end; ++edge)
         {
-            std::cout << actual_path[i][j] << " -> ";
+            auto v = graph.edge_array[edge];
+            if (ARGMIN_MASKED == tentative[v])
+            {
+                continue;
+            }
+
+            if (current_distance + graph.weight_array[edge] < tentative[v])
+            {
+                tentative[v] = current_distance + graph.weight_array[edge];
+                if (parents != nullptr)
+                {
+                    (*parents)[v] = current_vertex;
+                }
+            }
         }
-        std::cout << i << std::endl;
     }
-#endif
+
+    // The vertex the loop leaves over keeps its tentative distance (after the
+    // break above, all the remaining ones are FLT_MAX anyway)
+    auto last_vertex = graph.MinDistances(tentative);
+    distances[last_vertex] = tentative[last_vertex];
 
     return distances;
-}
\ No newline at end of file
+}
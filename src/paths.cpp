@@ -0,0 +1,64 @@
+#include "src/dijkstra.hpp"
+
+#include <algorithm>
+
+#include <omp.h>
+
+std::vector<int> dijkstra_path(const std::vector<int> &parents, int source_vertex, int target_vertex)
+{
+    std::vector<int> path;
+    if (target_vertex < 0 || static_cast<size_t>(target_vertex) >= parents.size() ||
+        parents[target_vertex] == DIJKSTRA_NO_PARENT)
+    {
+        return path;
+    }
+
+    // A valid tree reaches the source in fewer than V steps
+    for (auto v = target_vertex; path.size() < parents.size(); v = parents[v])
+    {
+        path.push_back(v);
+        if (v == source_vertex)
+        {
+            std::reverse(path.begin(), path.end());
+            return path;
+        }
+        if (parents[v] == DIJKSTRA_NO_PARENT)
+        {
+            break;
+        }
+    }
+
+    return std::vector<int>();
+}
+
+void dijkstra_parents_from_distances(const Graph &graph, int source_vertex, const std::vector<float> &distances,
+                                     std::vector<int> &parents)
+{
+    auto number_of_vertexes = static_cast<int>(graph.vertex_array.size());
+    parents.assign(number_of_vertexes, DIJKSTRA_NO_PARENT);
+
+    // Any tight edge will do, so concurrent writes to the same parent are
+    // benign; d[u] < d[v] keeps the tree acyclic even if d[u] + w rounds to d[u]
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (int u = 0; u < number_of_vertexes; ++u)
+    {
+        if (distances[u] == FLT_MAX)
+        {
+            continue;
+        }
+
+        auto edge_end = graph.EdgesEnd(u);
+        for (auto edge = graph.EdgesBegin(u); edge < edge_end; ++edge)
+        {
+            auto v = graph.edge_array[edge];
+            auto weight = graph.weight_array[edge];
+            if (v != source_vertex && weight > 0.f && distances[u] + weight == distances[v] && distances[u] < distances[v])
+            {
+                #pragma omp atomic write
+                parents[v] = u;
+            }
+        }
+    }
+
+    parents[source_vertex] = source_vertex;
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "src/dijkstra.hpp"
+#include "common/dary_heap.hpp"
+
+///
+/// Answer of a point-to-point query: the distance (FLT_MAX if the target is
+/// unreachable), the vertices of a shortest path from the source to the
+/// target (empty if unreachable) and the number of vertices the search
+/// settled, the measure of how much of the graph it had to look at.
+///
+struct PointToPointResult
+{
+    float distance;
+    std::vector<int> path;
+    long long settled;
+};
+
+///
+/// Bidirectional Dijkstra: a forward search from the source over the graph
+/// and a backward search from the target over Graph::Reverse(), always
+/// advancing the side with the smaller queue minimum.  Every edge scanned
+/// towards a vertex the other side has reached offers a path; the query stops
+/// as soon as the two minima together are no smaller than the best of them.
+///
+/// The search keeps its arrays between queries and resets only the vertices
+/// it touched, so a query costs what it explores instead of O(V).  Not
+/// thread-safe, use one per thread.
+///
+class BidirectionalDijkstra
+{
+public:
+    explicit BidirectionalDijkstra(const Graph &graph);
+
+    PointToPointResult Query(int source_vertex, int target_vertex);
+
+private:
+    // One side of the search
+    struct Side
+    {
+        const Graph *graph;
+        std::vector<float> distances;
+        std::vector<int> parents;
+        std::vector<int> touched;
+        IndexedDaryHeap<float> queue;
+    };
+
+    const Graph &graph;
+    Side forward;
+    Side backward;
+
+    // Settle the top of `side`, relax its edges and update the best meeting point
+    void step(Side &side, const Side &other, float &best, int &meeting_vertex, long long &settled);
+    void reset(Side &side);
+};
+
+///
+/// ALT preprocessing (A*, landmarks, triangle inequality; Goldberg and
+/// Harrelson): `count` landmarks picked by farthest selection, each next one
+/// the vertex farthest from the landmarks so far (vertices none of them
+/// reaches come first), and the distances from and to every landmark.
+///
+/// The distance tables come from `sssp`, any single-source engine: one run
+/// per landmark on the graph and one on Graph::Reverse().  They are stored
+/// vertex-major, the 2 * count distances of a vertex next to each other, so
+/// a lower bound reads one or two cache lines.
+///
+class AltIndex
+{
+public:
+    typedef std::function<std::vector<float>(const Graph &, int)> SsspEngine;
+
+    AltIndex(const Graph &graph, int count, SsspEngine sssp);
+
+    // Lower bound of the distance from `vertex` to `target_vertex` by the
+    // triangle inequality over every landmark
+    float LowerBound(int vertex, int target_vertex) const
+    {
+        auto bound = 0.f;
+        auto from_vertex = this->tables.data() + static_cast<size_t>(vertex) * 2 * this->count;
+        auto from_target = this->tables.data() + static_cast<size_t>(target_vertex) * 2 * this->count;
+        for (auto i = 0; i < this->count; ++i)
+        {
+            // d(L, t) - d(L, v) and d(v, L) - d(t, L); unreachable pairs give no bound
+            auto from_landmark_v = from_vertex[i], from_landmark_t = from_target[i];
+            auto to_landmark_v = from_vertex[this->count + i], to_landmark_t = from_target[this->count + i];
+            if (from_landmark_v != FLT_MAX && from_landmark_t != FLT_MAX)
+            {
+                bound = std::max(bound, from_landmark_t - from_landmark_v);
+            }
+            if (to_landmark_v != FLT_MAX && to_landmark_t != FLT_MAX)
+            {
+                bound = std::max(bound, to_landmark_v - to_landmark_t);
+            }
+        }
+        return bound;
+    }
+
+    const std::vector<int> &Landmarks() const { return this->landmarks; }
+    size_t Bytes() const { return this->tables.size() * sizeof(float); }
+    double PreprocessingSeconds() const { return this->preprocessing_seconds; }
+
+private:
+    int count;
+    std::vector<int> landmarks;
+    std::vector<float> tables;      // [v][0, count): d(L_i, v), [v][count, 2 count): d(v, L_i)
+    double preprocessing_seconds;
+};
+
+///
+/// Unidirectional A* from the source that stops when the target is settled,
+/// with the ALT lower bounds as the potential; without an index it is plain
+/// Dijkstra with early termination.  Float rounding can make the bounds
+/// marginally inconsistent, so a settled vertex is reopened if it improves.
+/// Scratch is reset through the touched vertices as in BidirectionalDijkstra.
+/// Not thread-safe, use one per thread.
+///
+class AStarSearch
+{
+public:
+    AStarSearch(const Graph &graph, const AltIndex *index);
+
+    PointToPointResult Query(int source_vertex, int target_vertex);
+
+private:
+    const Graph &graph;
+    const AltIndex *index;
+    std::vector<float> distances;
+    std::vector<float> potentials;      // lower bounds to the current target, FLT_MAX until computed
+    std::vector<int> parents;
+    std::vector<int> touched;
+    IndexedDaryHeap<float> queue;
+};
+
+///
+/// Contraction hierarchy (Geisberger, Sanders, Schultes, Delling).
+///
+/// Vertices are contracted in rounds.  Each round takes an independent set of
+/// vertices whose priority is a local minimum, so the set can be contracted
+/// in parallel.  The priority is the edge difference (shortcuts added minus
+/// arcs removed) of a simulated contraction plus the number of contracted
+/// neighbours.  Contracting v adds a shortcut u -> x for every pair of arcs
+/// u -> v -> x unless a witness search finds a path from u to x that is no
+/// longer.  The witness searches avoid every vertex of the round and give up,
+/// adding the shortcut, after settling CH_WITNESS_SETTLED_LIMIT vertices
+/// (CH_SIMULATION_SETTLED_LIMIT in a simulation).  After a round only the
+/// neighbours of the contracted vertices get new priorities (lazy updates).
+/// Dense vertices, with more than CH_DENSE_PAIRS_LIMIT pairs of arcs, are
+/// neither contracted nor expanded by witness searches.
+///
+/// Graphs without a hierarchy of their own (uniform random, Erdős–Rényi,
+/// R-MAT) densify as they are contracted until every pair around a vertex
+/// needs a shortcut.  The contraction therefore stops, checked after every
+/// contracted vertex, once the remaining graph averages CH_CORE_DEGREE_FACTOR
+/// times the out-arcs per vertex of the input or the shortcuts outnumber its
+/// edges CH_CORE_SHORTCUT_FACTOR times; the rest, with the dense vertices,
+/// stays uncontracted as the core.
+///
+/// The arcs of v at its contraction all lead to higher ranks and become its
+/// rows in the upward graph (out-arcs, for the forward search) and the
+/// downward graph (in-arcs, for the backward search), both in CSR.  Core
+/// vertices rank above all the others and keep their remaining arcs in both
+/// graphs.  Every arc keeps the vertex it bypasses so that paths can be
+/// unpacked.
+///
+class ContractionHierarchy
+{
+public:
+    // Called after every round with the vertices contracted so far and the shortcuts added,
+    // and once more with all of them when a core is left
+    typedef std::function<void(int contracted, int total, long long shortcuts)> Progress;
+
+    explicit ContractionHierarchy(const Graph &graph, Progress progress = nullptr);
+
+    int NumberOfVertexes() const { return static_cast<int>(this->ranks.size()); }
+    long long Shortcuts() const { return this->shortcuts; }
+    int Rounds() const { return this->rounds; }
+    int CoreVertexes() const { return this->core_vertexes; }
+    int Rank(int vertex) const { return this->ranks[vertex]; }
+    // Whether the vertex has out-edges / in-edges in the input graph
+    bool HasOutEdges(int vertex) const { return (this->edge_flags[vertex] & 1) != 0; }
+    bool HasInEdges(int vertex) const { return (this->edge_flags[vertex] & 2) != 0; }
+    bool InCore(int vertex) const { return this->ranks[vertex] >= this->NumberOfVertexes() - this->core_vertexes; }
+    double PreprocessingSeconds() const { return this->preprocessing_seconds; }
+    size_t Bytes() const;
+
+    // One direction of the hierarchy: arcs from a vertex to higher ranks
+    struct Arcs
+    {
+        std::vector<int> vertex_array;      // V + 1 entries
+        std::vector<int> targets;
+        std::vector<float> weights;
+        std::vector<int> middles;           // bypassed vertex of a shortcut, -1 for an edge of the graph
+    };
+
+    const Arcs &Upward() const { return this->upward; }
+    const Arcs &Downward() const { return this->downward; }
+
+    // Append the vertices after `from` on the path the arc from -> to (bypassing `middle`) stands for
+    void Unpack(int from, int to, int middle, std::vector<int> &path) const;
+
+private:
+    std::vector<int> ranks;
+    std::vector<unsigned char> edge_flags;  // 1: out-edges, 2: in-edges
+    Arcs upward;        // v -> x, rank(x) > rank(v)
+    Arcs downward;      // for v, the u with u -> v and rank(u) > rank(v)
+    long long shortcuts;
+    int rounds;
+    int core_vertexes;
+    double preprocessing_seconds;
+};
+
+///
+/// Query on a contraction hierarchy: a forward search from the source over
+/// the upward arcs and a backward search from the target over the downward
+/// ones, each stopping once its queue minimum reaches the best distance
+/// through a vertex both searches settled.  The upward searches do not
+/// expand core vertices; the core vertices they reach seed a bidirectional
+/// Dijkstra over the core arcs, which stops on the sum of the two queue
+/// minima.  Once an upward search runs dry below the core, the other one
+/// does not expand vertices above the highest rank it touched, as no
+/// meeting vertex can be there; a source without out-edges or a target
+/// without in-edges is answered without a search.  Scratch is reset through the touched
+/// vertices; not thread-safe, use one per thread.
+///
+class ContractionHierarchySearch
+{
+public:
+    explicit ContractionHierarchySearch(const ContractionHierarchy &hierarchy);
+
+    PointToPointResult Query(int source_vertex, int target_vertex);
+
+private:
+    // Search state of a vertex with a copy of its rank, so that a query
+    // reads one cache line per vertex and side
+    struct Label
+    {
+        float distance;
+        int parent;         // previous vertex on the search tree
+        int middle;         // middle of the arc from the parent
+        int rank;
+    };
+
+    struct Side
+    {
+        const ContractionHierarchy::Arcs *arcs;
+        std::vector<Label> labels;
+        std::vector<int> touched;
+        std::vector<int> entries;           // core vertices reached by the upward search
+        int top_rank;                       // highest rank touched
+        int rank_limit;                     // vertices above it are not expanded
+        IndexedDaryHeap<float> queue;
+    };
+
+    const ContractionHierarchy &hierarchy;
+    int core_rank;      // lowest rank of the core
+    Side forward;
+    Side backward;
+
+    // Record a shorter distance; vertices below the core are queued, core ones become entries
+    void reach(Side &side, int vertex, float distance, int parent, int middle);
+};
+
+// One-off bidirectional query; keep a BidirectionalDijkstra for repeated queries
+PointToPointResult dijkstra_point_to_point(const Graph &graph, int source_vertex, int target_vertex);
@@ -1,78 +1,133 @@
 #include "src/dijkstra.hpp"
-
-#include <iostream>
-#include <chrono>
+#include "common/argmin.hpp"
 
 std::vector<float> dijkstra_sequential(const Graph &graph,
-                                       int source_vertex)
+                                       int source_vertex,
+                                       std::vector<int> *parents)
 {
     auto number_of_vertexes = graph.vertex_array.size();
 
-    // finalized_verticies -- true if vertex i is included in the shortest path tree
-    //                      or the shortest distance from the source node to i is
-    //                      finalized
-    std::vector<bool>  finalized_verticies(number_of_vertexes, false);
+    // tentative -- distances of the vertices that are not finalized yet; once the
+    //              shortest distance from the source node to i is finalized
+    //              (i is included in the shortest path tree) it moves to
+    //              distances and tentative[i] is masked out as ARGMIN_MASKED,
+    //              so the argmin scans plain floats with no visited test
+    std::vector<float> tentative(number_of_vertexes, FLT_MAX);
     std::vector<float> distances(number_of_vertexes, FLT_MAX);
+    const auto &weight_matrix = graph.WeightMatrix();
 
-    std::vector<std::vector<int>> actual_path(number_of_vertexes);
-    for(auto&& path : actual_path)
+    if (parents != nullptr)
     {
-        path.push_back(source_vertex);
+        parents->assign(number_of_vertexes, DIJKSTRA_NO_PARENT);
+        (*parents)[source_vertex] = source_vertex;
     }
+
     // distances of the source vertex from itself is always 0
-    distances[source_vertex] = 0.f;
+    tentative[source_vertex] = 0.f;
 
     // --- Dijkstra iterations
     for (auto iter_count = 0ULL; iter_count < number_of_vertexes - 1; ++iter_count)
     {
-        int current_vertex = graph.MinDistances(distances, finalized_verticies, source_vertex);
+        int current_vertex = graph.MinDistances(tentative);
+        auto current_distance = tentative[current_vertex];
+
+        distances[current_vertex] = current_distance;
+        tentative[current_vertex] = ARGMIN_MASKED;
 
-        finalized_verticies[current_vertex] = true;
+        // Everything left is unreachable and already at FLT_MAX
+        if (FLT_MAX == current_distance)
+        {
+            break;
+        }
 
         // For all unvisited neighbors of current vertex
         for (auto v = 0ULL; v < number_of_vertexes; ++v)
         {
-            if (0 == graph.weight_matrix[current_vertex * number_of_vertexes + v] ||
-                FLT_MAX == distances[current_vertex])
+            auto weight = weight_matrix[current_vertex * number_of_vertexes + v];
+            if (0 == weight || ARGMIN_MASKED == tentative[v])
             {
                 continue;
             }
 
-            if (finalized_verticies[v])
+            if (current_distance + weight < tentative[v])
             {
-                continue;
-            }
-
-            if (distances[current_vertex] + graph.weight_matrix[current_vertex * number_of_vertexes + v] < distances[v])
-            {
-                distances[v] = distances[current_vertex] + graph.weight_matrix[current_vertex * number_of_vertexes + v];
-
-                if (!actual_path[v].size() || *actual_path[v].end() != current_vertex)
+                tentative[v] = current_distance + weight;
+                if (parents != nullptr)
                 {
-                    actual_path[v].push_back(current_vertex);
+                    (*parents)[v] = current_vertex;
                 }
             }
         }
     }
 
-#if ENABLE_PATH_PRINT != 0
-    std::cout << "Actual paths: " << std::endl;
-    for (auto i = 0ULL; i < actual_path.size(); ++i)
+    // The vertex the loop leaves over keeps its tentative distance (after the
+    // break above, all the remaining ones are FLT_MAX anyway)
+    auto last_vertex = graph.MinDistances(tentative);
+    distances[last_vertex] = tentative[last_vertex];
+
+    return distances;
+}
+
+std::vector<float> dijkstra_sequential_csr(const Graph &graph,
+                                           int source_vertex,
+                                           std::vector<int> *parents)
+{
+    auto number_of_vertexes = graph.vertex_array.size();
+
+    // Same O(V^2) scheme as dijkstra_sequential, but the relaxation walks the
+    // CSR row of the current vertex, so the weight matrix is never touched
+    std::vector<float> tentative(number_of_vertexes, FLT_MAX);
+    std::vector<float> distances(number_of_vertexes, FLT_MAX);
+
+    if (parents != nullptr)
+    {
+        parents->assign(number_of_vertexes, DIJKSTRA_NO_PARENT);
+        (*parents)[source_vertex] = source_vertex;
+    }
+
+    // distances of the source vertex from itself is always 0
+    tentative[source_vertex] = 0.f;
+
+    // --- Dijkstra iterations
+    for (auto iter_count = 0ULL; iter_count < number_of_vertexes - 1; ++iter_count)
     {
-        std::cout << "Path from " << source_vertex << " to " << i  << ": ";
-        if (actual_path[i].size() == 0)
+        int current_vertex = graph.MinDistances(tentative);
+        auto current_distance = tentative[current_vertex];
+
+        distances[current_vertex] = current_distance;
+        tentative[current_vertex] = ARGMIN_MASKED;
+
+        // Everything left is unreachable and already at FLT_MAX
+        if (FLT_MAX == current_distance)
         {
-            std::cout << "None (Direct?)" << std::endl;
-            continue;
+            break;
         }
 
-        // std::cout << source_vertex << " -> ";
-        for (auto j = 0ULL; j < actual_path[i].size(); ++j)
+        // For all unvisited neighbors of current vertex
+        auto edge_end = graph.EdgesEnd(current_vertex);
+        for (auto edge = graph.EdgesBegin(current_vertex); edge < edge_end; ++edge)
         {
-            std::cout << actual_path[i][j] << " -> ";
+            auto v = graph.edge_array[edge];
+            if (ARGMIN_MASKED == tentative[v])
+            {
+                continue;
+            }
+
+            if (current_distance + graph.weight_array[edge] < tentative[v])
+            {
+                tentative[v] = current_distance + graph.weight_array[edge];
+                if (parents != nullptr)
+                {
+                    (*parents)[v] = current_vertex;
+                }
+            }
         }
-        std::cout << i << std::endl;
     }
-#endif
+
+    // The vertex the loop leaves over keeps its tentative distance (after the
+    // break above, all the remaining ones are FLT_MAX anyway)
+    auto last_vertex = graph.MinDistances(tentative);
+    distances[last_vertex] = tentative[last_vertex];
+
     return distances;
-}
\ No newline at end of file
+}
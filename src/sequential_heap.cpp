@@ -0,0 +1,153 @@
+#include "src/dijkstra.hpp"
+#include "common/dary_heap.hpp"
+
+#include <algorithm>
+
+#include <omp.h>
+
+///
+/// Outgoing edges of the plain CSR arrays, in the shape of
+/// CompressedGraph::ForEachEdge
+///
+struct CsrEdges
+{
+    const Graph &graph;
+
+    template <typename Visitor>
+    void ForEachEdge(int vertex, Visitor visit) const
+    {
+        auto edge_end = this->graph.EdgesEnd(vertex);
+        for (auto edge = this->graph.EdgesBegin(vertex); edge < edge_end; ++edge)
+        {
+            visit(this->graph.edge_array[edge], this->graph.weight_array[edge]);
+        }
+    }
+};
+
+///
+/// One heap-based query over `edges` (CsrEdges, a CompressedGraph or an
+/// IntegerGraph).  `distances` must hold infinity (FLT_MAX, or
+/// INTEGER_DISTANCE_INFINITY) for every vertex and `queue` must be empty; it
+/// is empty again on return, so both can be reused for the next query
+/// without reallocating.
+///
+template <typename Edges, typename Distance>
+static void heap_query(const Edges &edges, int source_vertex, Distance *distances,
+                       IndexedDaryHeap<Distance> &queue, std::vector<int> *parents)
+{
+    // distances of the source vertex from itself is always 0
+    distances[source_vertex] = 0;
+    queue.Push(source_vertex, 0);
+
+    // --- Dijkstra iterations
+    while (!queue.Empty())
+    {
+        auto current_distance = queue.TopKey();
+        auto current_vertex = queue.Pop();
+
+        // Relax only the actual outgoing edges of the current vertex
+        edges.ForEachEdge(current_vertex, [&](int v, Distance weight)
+        {
+            auto candidate = current_distance + weight;
+
+            if (candidate < distances[v])
+            {
+                distances[v] = candidate;
+                queue.PushOrDecrease(v, candidate);
+                if (parents != nullptr)
+                {
+                    (*parents)[v] = current_vertex;
+                }
+            }
+        });
+    }
+}
+
+std::vector<float> dijkstra_sequential_heap(const Graph &graph,
+                                            int source_vertex,
+                                            std::vector<int> *parents)
+{
+    auto number_of_vertexes = static_cast<int>(graph.vertex_array.size());
+
+    std::vector<float> distances(number_of_vertexes, FLT_MAX);
+    // The heap only ever holds tentative (not yet finalized) vertices
+    IndexedDaryHeap<float> queue(number_of_vertexes);
+
+    if (parents != nullptr)
+    {
+        parents->assign(number_of_vertexes, DIJKSTRA_NO_PARENT);
+        (*parents)[source_vertex] = source_vertex;
+    }
+
+    heap_query(CsrEdges{graph}, source_vertex, distances.data(), queue, parents);
+
+    return distances;
+}
+
+std::vector<float> dijkstra_compressed_heap(const CompressedGraph &graph,
+                                            int source_vertex,
+                                            std::vector<int> *parents)
+{
+    auto number_of_vertexes = graph.NumberOfVertexes();
+
+    std::vector<float> distances(number_of_vertexes, FLT_MAX);
+    IndexedDaryHeap<float> queue(number_of_vertexes);
+
+    if (parents != nullptr)
+    {
+        parents->assign(number_of_vertexes, DIJKSTRA_NO_PARENT);
+        (*parents)[source_vertex] = source_vertex;
+    }
+
+    heap_query(graph, source_vertex, distances.data(), queue, parents);
+
+    return distances;
+}
+
+std::vector<IntegerDistance> dijkstra_integer_heap(const IntegerGraph &graph,
+                                                   int source_vertex,
+                                                   std::vector<int> *parents)
+{
+    auto number_of_vertexes = static_cast<int>(graph.vertex_array.size());
+
+    std::vector<IntegerDistance> distances(number_of_vertexes, INTEGER_DISTANCE_INFINITY);
+    IndexedDaryHeap<IntegerDistance> queue(number_of_vertexes);
+
+    if (parents != nullptr)
+    {
+        parents->assign(number_of_vertexes, DIJKSTRA_NO_PARENT);
+        (*parents)[source_vertex] = source_vertex;
+    }
+
+    heap_query(graph, source_vertex, distances.data(), queue, parents);
+
+    return distances;
+}
+
+std::vector<float> dijkstra_batch(const Graph &graph, const std::vector<int> &sources)
+{
+    auto number_of_vertexes = graph.vertex_array.size();
+    auto number_of_sources = static_cast<long long>(sources.size());
+
+    // Every row is written by exactly one query, so the rows are filled in
+    // place instead of being copied out of per-query vectors
+    std::vector<float> distances(sources.size() * number_of_vertexes);
+
+    #pragma omp parallel
+    {
+        // Per-thread scratch, reused by all the queries of the thread
+        IndexedDaryHeap<float> queue(static_cast<int>(number_of_vertexes));
+
+        // Query costs vary a lot (unreachable parts, hubs), so hand the
+        // sources out one at a time
+        #pragma omp for schedule(dynamic, 1)
+        for (long long i = 0; i < number_of_sources; ++i)
+        {
+            auto row = distances.data() + i * number_of_vertexes;
+            std::fill(row, row + number_of_vertexes, FLT_MAX);
+            heap_query(CsrEdges{graph}, sources[i], row, queue, nullptr);
+        }
+    }
+
+    return distances;
+}
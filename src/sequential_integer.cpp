@@ -0,0 +1,81 @@
+#include "src/dijkstra.hpp"
+#include "common/bucket_queue.hpp"
+#include "common/radix_heap.hpp"
+
+///
+/// Dijkstra over a monotone queue without DecreaseKey (RadixHeap,
+/// BucketQueue): an improved vertex is pushed again and the entries whose key
+/// is larger than the distance of their vertex are skipped when popped
+///
+template <typename Queue>
+static std::vector<IntegerDistance> monotone_query(const IntegerGraph &graph, int source_vertex, Queue &queue,
+                                                   std::vector<int> *parents)
+{
+    auto number_of_vertexes = static_cast<int>(graph.vertex_array.size());
+
+    std::vector<IntegerDistance> distances(number_of_vertexes, INTEGER_DISTANCE_INFINITY);
+
+    if (parents != nullptr)
+    {
+        parents->assign(number_of_vertexes, DIJKSTRA_NO_PARENT);
+        (*parents)[source_vertex] = source_vertex;
+    }
+
+    // distances of the source vertex from itself is always 0
+    distances[source_vertex] = 0;
+    queue.Push(source_vertex, 0);
+
+    // --- Dijkstra iterations
+    while (!queue.Empty())
+    {
+        int current_vertex;
+        IntegerDistance current_distance;
+        queue.Pop(current_vertex, current_distance);
+        if (current_distance > distances[current_vertex])
+        {
+            continue;
+        }
+
+        auto edge_end = graph.EdgesEnd(current_vertex);
+        for (auto edge = graph.EdgesBegin(current_vertex); edge < edge_end; ++edge)
+        {
+            auto v = graph.edge_array[edge];
+            auto candidate = current_distance + graph.weight_array[edge];
+
+            if (candidate < distances[v])
+            {
+                distances[v] = candidate;
+                queue.Push(v, candidate);
+                if (parents != nullptr)
+                {
+                    (*parents)[v] = current_vertex;
+                }
+            }
+        }
+    }
+
+    return distances;
+}
+
+std::vector<IntegerDistance> dijkstra_radix_heap(const IntegerGraph &graph,
+                                                 int source_vertex,
+                                                 std::vector<int> *parents)
+{
+    RadixHeap<IntegerDistance> queue;
+    return monotone_query(graph, source_vertex, queue, parents);
+}
+
+std::vector<IntegerDistance> dijkstra_dial(const IntegerGraph &graph,
+                                           int source_vertex,
+                                           std::vector<int> *parents)
+{
+    // One bucket per possible weight; beyond that the scans over empty
+    // buckets cost more than the radix heap saves
+    if (graph.MaxWeight() > DIAL_MAX_BUCKETS)
+    {
+        return dijkstra_radix_heap(graph, source_vertex, parents);
+    }
+
+    BucketQueue<IntegerDistance> queue(graph.MaxWeight());
+    return monotone_query(graph, source_vertex, queue, parents);
+}
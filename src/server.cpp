@@ -0,0 +1,651 @@
+#include "src/server.hpp"
+#include "common/distance_cache.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Latencies kept per request kind for the percentiles, the most recent ones
+#define SERVER_LATENCY_WINDOW 65536
+
+namespace
+{
+
+///
+/// The latest SERVER_LATENCY_WINDOW latencies of one request kind, a ring
+///
+class LatencyWindow
+{
+    std::vector<double> samples;
+    size_t next;
+    long long count;
+
+public:
+    LatencyWindow() : next(0), count(0)
+    {
+    }
+
+    void Add(double seconds)
+    {
+        if (this->samples.size() < SERVER_LATENCY_WINDOW)
+        {
+            this->samples.push_back(seconds);
+        }
+        else
+        {
+            this->samples[this->next] = seconds;
+            this->next = (this->next + 1) % SERVER_LATENCY_WINDOW;
+        }
+        ++this->count;
+    }
+
+    long long Count() const { return this->count; }
+    TimingStats Stats() const { return compute_stats(this->samples); }
+};
+
+enum request_kind_e
+{
+    REQUEST_SSSP,
+    REQUEST_BATCH,
+    REQUEST_PATH,
+    REQUEST_KINDS,
+};
+
+const char *const request_names[REQUEST_KINDS] = { "sssp", "batch", "path" };
+
+class QueryServer
+{
+    const Graph &graph;
+    const std::vector<Backend> &backends;
+    const std::vector<PointToPointEngine> &p2p_engines;
+    const Backend *backend;
+    const PointToPointEngine *p2p_engine;
+    DistanceCache cache;
+    LatencyWindow latencies[REQUEST_KINDS];
+
+public:
+    QueryServer(const Graph &graph, const std::vector<Backend> &backends,
+                const std::vector<PointToPointEngine> &p2p_engines, size_t cache_bytes) :
+        graph(graph), backends(backends), p2p_engines(p2p_engines), backend(nullptr), p2p_engine(nullptr),
+        cache(cache_bytes)
+    {
+    }
+
+    // Make `name` the SSSP backend and prepare it; the cached distances go
+    bool SelectBackend(const std::string &name, std::string &error)
+    {
+        auto found = std::find_if(this->backends.begin(), this->backends.end(), [&name](const Backend &backend)
+        {
+            return backend.name == name;
+        });
+        if (found == this->backends.end())
+        {
+            error = "unknown or unavailable backend " + name;
+            return false;
+        }
+
+        if (found->prepare)
+        {
+            found->prepare(this->graph);
+        }
+        this->backend = &*found;
+        this->cache.Clear();
+        return true;
+    }
+
+    bool SelectPointToPoint(const std::string &name, std::string &error)
+    {
+        auto found = std::find_if(this->p2p_engines.begin(), this->p2p_engines.end(),
+                                  [&name](const PointToPointEngine &engine) { return engine.name == name; });
+        if (found == this->p2p_engines.end())
+        {
+            error = "unknown point-to-point engine " + name;
+            return false;
+        }
+
+        if (found->prepare)
+        {
+            found->prepare(this->graph);
+        }
+        this->p2p_engine = &*found;
+        return true;
+    }
+
+    const Backend &CurrentBackend() const { return *this->backend; }
+    const PointToPointEngine &CurrentPointToPoint() const { return *this->p2p_engine; }
+
+    // The reply to one request line; `close` ends the connection, `shutdown` the server
+    std::string Handle(const std::string &line, bool &close, bool &shutdown)
+    {
+        std::istringstream request(line);
+        std::string command;
+        request >> command;
+
+        std::vector<std::string> arguments;
+        std::string argument;
+        while (request >> argument)
+        {
+            arguments.push_back(argument);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        std::ostringstream reply;
+        reply << std::setprecision(9) << "ok";
+
+        int kind = -1;
+        std::string error;
+        if (command == "sssp" || command == "batch")
+        {
+            kind = command == "sssp" ? REQUEST_SSSP : REQUEST_BATCH;
+            std::vector<int> sources, targets;
+            if (arguments.empty())
+            {
+                error = "usage: " + command + (kind == REQUEST_SSSP ? " S [T ...]" : " S1,S2,... [T ...]");
+            }
+            else if (this->parse_vertexes(kind == REQUEST_SSSP ? std::vector<std::string>(1, arguments[0])
+                                                                : split(arguments[0], ','), sources, error) &&
+                     this->parse_vertexes(std::vector<std::string>(arguments.begin() + 1, arguments.end()),
+                                          targets, error))
+            {
+                std::vector<DistanceCache::Entry> rows;
+                if (this->distances_from(sources, rows, error))
+                {
+                    for (auto i = 0ULL; i < sources.size(); ++i)
+                    {
+                        reply << (i > 0 ? " ;" : "");
+                        if (targets.empty())
+                        {
+                            for (auto distance : *rows[i])
+                            {
+                                write_distance(reply, distance);
+                            }
+                        }
+                        for (auto target : targets)
+                        {
+                            write_distance(reply, (*rows[i])[target]);
+                        }
+                    }
+                }
+            }
+        }
+        else if (command == "path")
+        {
+            kind = REQUEST_PATH;
+            std::vector<int> vertexes;
+            if (arguments.size() != 2)
+            {
+                error = "usage: path S T";
+            }
+            else if (this->parse_vertexes(arguments, vertexes, error))
+            {
+                auto answer = this->p2p_engine->query(this->graph, vertexes[0], vertexes[1]);
+                write_distance(reply, answer.distance);
+                for (auto v : answer.path)
+                {
+                    reply << " " << v;
+                }
+            }
+        }
+        else if (command == "backend")
+        {
+            if (!arguments.empty() && !this->SelectBackend(arguments[0], error))
+            {
+                return "error " + error;
+            }
+            reply << " " << this->backend->name;
+        }
+        else if (command == "stats")
+        {
+            this->write_stats(reply);
+        }
+        else if (command == "quit" || command == "shutdown")
+        {
+            close = true;
+            shutdown = command == "shutdown";
+        }
+        else
+        {
+            error = command.empty() ? "empty request" : "unknown request " + command;
+        }
+
+        if (!error.empty())
+        {
+            return "error " + error;
+        }
+        if (kind >= 0)
+        {
+            std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+            this->latencies[kind].Add(elapsed.count());
+        }
+        return reply.str();
+    }
+
+private:
+    static std::vector<std::string> split(const std::string &value, char separator)
+    {
+        std::vector<std::string> parts;
+        std::istringstream stream(value);
+        std::string part;
+        while (std::getline(stream, part, separator))
+        {
+            parts.push_back(part);
+        }
+        return parts;
+    }
+
+    static void write_distance(std::ostream &reply, float distance)
+    {
+        if (distance == FLT_MAX)
+        {
+            reply << " inf";
+        }
+        else
+        {
+            reply << " " << distance;
+        }
+    }
+
+    bool parse_vertexes(const std::vector<std::string> &items, std::vector<int> &vertexes, std::string &error) const
+    {
+        auto number_of_vertexes = static_cast<long long>(this->graph.vertex_array.size());
+        for (const auto &item : items)
+        {
+            char *end = nullptr;
+            auto vertex = std::strtoll(item.c_str(), &end, 10);
+            if (item.empty() || *end != '\0' || vertex < 0 || vertex >= number_of_vertexes)
+            {
+                error = "no vertex " + item;
+                return false;
+            }
+            vertexes.push_back(static_cast<int>(vertex));
+        }
+        return true;
+    }
+
+    // Distances from every source, from the cache or the backend.  Every
+    // distinct source is looked up once; the misses of a batch run together
+    // through the backend's batch entry point when it has one.  A result that
+    // is not V long is an engine failure: it is neither cached nor returned
+    bool distances_from(const std::vector<int> &sources, std::vector<DistanceCache::Entry> &rows,
+                        std::string &error)
+    {
+        std::vector<int> distinct;
+        for (auto source_vertex : sources)
+        {
+            if (std::find(distinct.begin(), distinct.end(), source_vertex) == distinct.end())
+            {
+                distinct.push_back(source_vertex);
+            }
+        }
+
+        std::vector<DistanceCache::Entry> found;
+        std::vector<int> missing;
+        for (auto source_vertex : distinct)
+        {
+            found.push_back(this->cache.Find(source_vertex));
+            if (found.back() == nullptr)
+            {
+                missing.push_back(source_vertex);
+            }
+        }
+
+        auto number_of_vertexes = this->graph.vertex_array.size();
+        std::vector<DistanceCache::Entry> computed;
+        if (missing.size() > 1 && this->backend->batch)
+        {
+            auto table = this->backend->batch(this->graph, missing);
+            if (table.size() != missing.size() * number_of_vertexes)
+            {
+                error = "backend " + this->backend->name + " returned no distances from the batch";
+                return false;
+            }
+            for (auto i = 0ULL; i < missing.size(); ++i)
+            {
+                computed.push_back(std::make_shared<const std::vector<float>>(
+                    table.begin() + i * number_of_vertexes, table.begin() + (i + 1) * number_of_vertexes));
+            }
+        }
+        else
+        {
+            for (auto source_vertex : missing)
+            {
+                computed.push_back(std::make_shared<const std::vector<float>>(
+                    this->backend->run(this->graph, source_vertex, nullptr)));
+            }
+        }
+
+        for (auto i = 0ULL; i < missing.size(); ++i)
+        {
+            if (computed[i]->size() != number_of_vertexes)
+            {
+                error = "backend " + this->backend->name + " returned no distances from " +
+                        std::to_string(missing[i]);
+                return false;
+            }
+            this->cache.Insert(missing[i], computed[i]);
+        }
+
+        auto next_computed = computed.begin();
+        for (auto &entry : found)
+        {
+            if (entry == nullptr)
+            {
+                entry = *next_computed++;
+            }
+        }
+        for (auto source_vertex : sources)
+        {
+            rows.push_back(found[std::find(distinct.begin(), distinct.end(), source_vertex) - distinct.begin()]);
+        }
+        return true;
+    }
+
+    void write_stats(std::ostream &reply) const
+    {
+        auto lookups = this->cache.Hits() + this->cache.Misses();
+        reply << " backend=" << this->backend->name << " p2p=" << this->p2p_engine->name
+              << " vertices=" << this->graph.vertex_array.size() << " edges=" << this->graph.edge_array.size();
+        for (auto kind = 0; kind < REQUEST_KINDS; ++kind)
+        {
+            auto stats = this->latencies[kind].Stats();
+            reply << std::fixed << std::setprecision(6) << " " << request_names[kind] << "="
+                  << this->latencies[kind].Count() << " " << request_names[kind] << "_p50=" << stats.median << " "
+                  << request_names[kind] << "_p95=" << stats.p95 << " " << request_names[kind] << "_p99="
+                  << stats.p99;
+        }
+        reply << std::setprecision(3) << " cache_hits=" << this->cache.Hits() << " cache_misses="
+              << this->cache.Misses() << " hit_rate=" << (lookups > 0 ? static_cast<double>(this->cache.Hits()) / lookups : 0.)
+              << " cache_entries=" << this->cache.Size() << " cache_bytes=" << this->cache.Bytes()
+              << " cache_budget=" << this->cache.Budget();
+    }
+};
+
+bool send_all(int fd, const std::string &data)
+{
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+        auto written = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return false;
+        }
+        sent += static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// The same for descriptors that are not sockets (the replies on stdout)
+bool write_all(int fd, const std::string &data)
+{
+    size_t done = 0;
+    while (done < data.size())
+    {
+        auto written = write(fd, data.data() + done, data.size() - done);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return false;
+        }
+        done += static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool socket_address(const std::string &path, sockaddr_un &address)
+{
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        std::cerr << "Socket path is too long: " << path << std::endl;
+        return false;
+    }
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    return true;
+}
+
+int listen_on(const std::string &path)
+{
+    sockaddr_un address;
+    if (!socket_address(path, address))
+    {
+        return -1;
+    }
+
+    // A socket left behind by an earlier run is replaced, any other file is not
+    struct stat status;
+    if (lstat(path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode))
+    {
+        unlink(path.c_str());
+    }
+
+    auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        std::cerr << "Cannot listen on " << path << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+// Requests come from every connection in turn: a client waits while the
+// request of another one runs, the backends use every core by themselves
+void serve_socket(QueryServer &server, int listener)
+{
+    std::vector<pollfd> fds(1);
+    std::vector<std::string> buffers(1);
+    fds[0].fd = listener;
+    fds[0].events = POLLIN;
+
+    auto shutdown = false;
+    while (!shutdown)
+    {
+        if (poll(fds.data(), fds.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            std::cerr << "poll failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        for (auto i = fds.size(); i-- > 1 && !shutdown; )
+        {
+            if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) == 0)
+            {
+                continue;
+            }
+
+            char chunk[4096];
+            auto received = recv(fds[i].fd, chunk, sizeof(chunk), 0);
+            auto close_client = received <= 0;
+            if (!close_client)
+            {
+                buffers[i].append(chunk, static_cast<size_t>(received));
+            }
+
+            size_t end;
+            while (!close_client && (end = buffers[i].find('\n')) != std::string::npos)
+            {
+                auto line = buffers[i].substr(0, end);
+                buffers[i].erase(0, end + 1);
+                if (!line.empty() && line.back() == '\r')
+                {
+                    line.pop_back();
+                }
+                auto reply = server.Handle(line, close_client, shutdown) + "\n";
+                close_client = !send_all(fds[i].fd, reply) || close_client;
+            }
+
+            if (close_client)
+            {
+                close(fds[i].fd);
+                fds.erase(fds.begin() + i);
+                buffers.erase(buffers.begin() + i);
+            }
+        }
+
+        if (!shutdown && (fds[0].revents & POLLIN) != 0)
+        {
+            auto client = accept(listener, nullptr, nullptr);
+            if (client >= 0)
+            {
+                pollfd entry;
+                entry.fd = client;
+                entry.events = POLLIN;
+                entry.revents = 0;
+                fds.push_back(entry);
+                buffers.push_back(std::string());
+            }
+        }
+    }
+
+    for (auto i = 1ULL; i < fds.size(); ++i)
+    {
+        close(fds[i].fd);
+    }
+}
+
+}
+
+int reserve_stdout_for_replies()
+{
+    std::cout.flush();
+    std::fflush(stdout);
+
+    auto reply_fd = dup(STDOUT_FILENO);
+    if (reply_fd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0)
+    {
+        std::cerr << "Cannot redirect stdout: " << std::strerror(errno) << std::endl;
+        if (reply_fd >= 0)
+        {
+            close(reply_fd);
+        }
+        return -1;
+    }
+    return reply_fd;
+}
+
+int run_server(const ServerOptions &options, const Graph &graph, const std::vector<Backend> &backends,
+               const std::vector<PointToPointEngine> &p2p_engines)
+{
+    QueryServer server(graph, backends, p2p_engines, options.cache_bytes);
+
+    // On stdin/stdout fd 1 already goes to stderr (reserve_stdout_for_replies),
+    // whatever the preparation prints cannot reach the replies
+    auto on_stdin = options.socket_path == "-";
+    std::string error;
+    auto ready = server.SelectBackend(options.backend, error) && server.SelectPointToPoint(options.p2p_engine, error);
+    if (!ready)
+    {
+        std::cerr << "Cannot start the server: " << error << std::endl;
+        return 1;
+    }
+
+    std::cerr << "Serving " << graph.vertex_array.size() << " vertices and " << graph.edge_array.size()
+              << " edges with " << server.CurrentBackend().name << " (point-to-point "
+              << server.CurrentPointToPoint().name << "), cache " << options.cache_bytes / 1048576. << " MiB, on "
+              << (on_stdin ? "stdin" : options.socket_path) << std::endl;
+
+    if (on_stdin)
+    {
+        std::string line;
+        auto close = false, shutdown = false;
+        while (!close && std::getline(std::cin, line))
+        {
+            if (!write_all(options.reply_fd, server.Handle(line, close, shutdown) + "\n"))
+            {
+                std::cerr << "Cannot write the reply: " << std::strerror(errno) << std::endl;
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    auto listener = listen_on(options.socket_path);
+    if (listener < 0)
+    {
+        return 1;
+    }
+    serve_socket(server, listener);
+    close(listener);
+    unlink(options.socket_path.c_str());
+    return 0;
+}
+
+int run_client(const std::string &socket_path)
+{
+    sockaddr_un address;
+    if (!socket_address(socket_path, address))
+    {
+        return 1;
+    }
+
+    auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+    {
+        std::cerr << "Cannot connect to " << socket_path << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return 1;
+    }
+
+    // One reply line per request line
+    std::string line, pending;
+    auto connected = true;
+    while (connected && std::getline(std::cin, line))
+    {
+        connected = send_all(fd, line + "\n");
+
+        size_t end = 0;
+        while (connected && (end = pending.find('\n')) == std::string::npos)
+        {
+            char chunk[4096];
+            auto received = recv(fd, chunk, sizeof(chunk), 0);
+            connected = received > 0;
+            if (connected)
+            {
+                pending.append(chunk, static_cast<size_t>(received));
+            }
+        }
+        if (connected)
+        {
+            std::cout << pending.substr(0, end) << std::endl;
+            pending.erase(0, end + 1);
+        }
+    }
+
+    close(fd);
+    if (!connected)
+    {
+        std::cerr << "The server closed the connection" << std::endl;
+    }
+    return 0;
+}
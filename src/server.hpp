@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "src/benchmark.hpp"
+
+///
+/// Query server over a resident graph.  Requests and replies are single
+/// lines; a reply starts with "ok" or "error <message>":
+///
+///   sssp S [T ...]          distances from S to the targets, to every vertex without targets
+///   batch S1,S2,... [T ...] the same for every source, the lists separated by " ; "
+///   path S T                distance and vertices of a shortest path ("ok inf" if none)
+///   backend [NAME]          switch the SSSP backend (empties the cache), or name the current one
+///   stats                   query counts, latency percentiles per request kind, cache hit rate
+///   quit                    close this connection (end the session on stdin)
+///   shutdown                stop the server
+///
+/// Single-source distances come from the selected backend and are cached
+/// per source (DistanceCache), every distinct source of a batch is looked
+/// up once; the misses of a batch run together through the backend's batch
+/// entry point when it has one (heap: dijkstra_batch, in parallel).  Point-to-point requests go to
+/// the selected point-to-point engine.  Unreachable distances are written
+/// as "inf".
+///
+struct ServerOptions
+{
+    std::string socket_path;    // Unix domain socket to listen on, "-" for stdin/stdout
+    std::string backend;
+    std::string p2p_engine;
+    size_t cache_bytes;         // budget of the distance cache
+    int reply_fd;               // stdin/stdout: where the replies go (reserve_stdout_for_replies)
+};
+
+// Serving on stdin/stdout the protocol owns stdout: returns a duplicate of
+// fd 1 for the replies and points fd 1 at stderr, so that nothing else the
+// process prints (device probing, loading, backend preparation, printf or
+// iostreams) reaches the reply stream.  Returns -1 on failure.
+int reserve_stdout_for_replies();
+
+// Returns the process exit code
+int run_server(const ServerOptions &options, const Graph &graph, const std::vector<Backend> &backends,
+               const std::vector<PointToPointEngine> &p2p_engines);
+
+// Send the lines of stdin to the server at `socket_path` and print the replies
+int run_client(const std::string &socket_path);